@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// The libuv event loop adapter driven directly, without getdns or a
+// network, at high rates.  Events are scheduled with a timeout and
+// cleared again.  With --poll each event up to --fds also reads its own
+// socketpair fd, as a query in flight does; the rest are timeout only.
+// Two modes:
+//   immediate - cleared in the same tick, as when an answer is already
+//               waiting; libuv never arms the fds
+//   armed     - cleared after a turn of the loop, so the fds are added
+//               to the poller first, as for a query in flight
+//
+//   node-gyp rebuild -- -Dbuild_bench=true
+//   node bench/adapter.js [--pairs=200000] [--batch=1000] [--fds=256]
+//       [--mode=immediate|armed] [--poll=true] [--json]
+//
+// Reports ns per schedule / clear pair, the time the loop then spends
+// closing the handles, the peak number of live events and the poll
+// starts and stops per pair, which stand in for epoll_ctl calls.
+
+var common = require('./lib/common'),
+    report = require('./lib/report');
+
+var opts = common.parseArgs({
+    pairs : 200000,
+    batch : 1000,
+    fds : 256,
+    timeout : 5000,
+    mode : 'immediate',
+    poll : true,
+    json : false
+});
+
+if (opts.mode !== 'immediate' && opts.mode !== 'armed') {
+    throw new Error('unknown mode ' + opts.mode);
+}
+
+var bench;
+try {
+    bench = require('bindings')('getdns_bench');
+} catch (e) {
+    console.error('getdns_bench is not built, run node-gyp rebuild -- -Dbuild_bench=true');
+    process.exit(1);
+}
+
+var counters = function() {
+    return bench.nativeStats().event_loop;
+};
+
+var before = counters();
+var scheduleNanos = 0, clearNanos = 0, closeNanos = 0;
+var peakLive = 0, done = 0;
+
+var batch = function() {
+    if (done >= opts.pairs) {
+        return finish();
+    }
+    var n = Math.min(opts.batch, opts.pairs - done);
+    done += n;
+    scheduleNanos += bench.adapterSchedule(n, opts.fds, opts.timeout, opts.poll);
+    var clear = function() {
+        clearNanos += bench.adapterClear();
+        peakLive = Math.max(peakLive, counters().live_events);
+        // the handles close in the next turn of the loop
+        var start = process.hrtime();
+        setImmediate(function() {
+            closeNanos += common.elapsedMicros(start) * 1000;
+            batch();
+        });
+    };
+    if (opts.mode === 'immediate') {
+        clear();
+    } else {
+        setImmediate(clear);
+    }
+};
+
+var finish = function() {
+    var after = counters();
+    report.print({
+        name : 'adapter ' + opts.mode,
+        pairs : opts.pairs,
+        schedule_ns : scheduleNanos / opts.pairs,
+        clear_ns : clearNanos / opts.pairs,
+        pair_ns : (scheduleNanos + clearNanos) / opts.pairs,
+        close_ns : closeNanos / opts.pairs,
+        peak_live_events : peakLive,
+        leaked_events : after.live_events - before.live_events,
+        poll_starts_per_pair : (after.poll_starts - before.poll_starts) / opts.pairs,
+        poll_stops_per_pair : (after.poll_stops - before.poll_stops) / opts.pairs,
+        timer_starts_per_pair : (after.timer_starts - before.timer_starts) / opts.pairs
+    }, opts.json);
+};
+
+batch();
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Cancellation storm.  Issues lookups against a local responder that
+// holds its answers back and cancels a fraction of them at random
+// points in their lifetime: straight after the call, on the next tick
+// or while waiting for the answer.
+//
+//   node bench/cancel.js [--queries=100000] [--concurrency=500]
+//       [--fraction=0.5] [--delay=5] [--max-in-flight=0] [--json]
+//
+// --delay is the responder's hold time in millis.  With --max-in-flight
+// some queries are still queued in the binding when cancelled.
+//
+// Reports the cost of cancel(), the time from cancel() to the
+// CALLBACK_CANCEL callback, and any queries or event loop handles left
+// behind once everything has completed.  getdns delivers the cancel
+// callback from within cancel(), so the cost of cancel() includes the
+// callback into JS.
+
+var common = require('./lib/common'),
+    responder = require('./lib/responder'),
+    report = require('./lib/report'),
+    Histogram = require('./lib/histogram');
+
+var getdns = common.getdns;
+
+var opts = common.parseArgs({
+    queries : 100000,
+    concurrency : 500,
+    fraction : 0.5,
+    delay : 5,
+    max_in_flight : 0,
+    json : false
+});
+
+var run = function(port, done) {
+    var ctx = common.stubContext(port);
+    if (opts.max_in_flight > 0) {
+        ctx.max_in_flight = opts.max_in_flight;
+    }
+    var before = getdns.nativeStats();
+    var cancelCost = new Histogram(), delivery = new Histogram();
+    var issued = 0, completed = 0, cancelled = 0, answered = 0;
+    var cancelCalls = 0, cancelRejected = 0;
+    var points = { sync : 0, tick : 0, in_flight : 0 };
+
+    var issue = function() {
+        var cancelStart = null;
+        var callback = function(err, result) {
+            completed++;
+            if (err && err.code === getdns.CALLBACK_CANCEL) {
+                cancelled++;
+                if (cancelStart) {
+                    delivery.record(common.elapsedMicros(cancelStart) * 1000);
+                }
+            } else if (!err) {
+                answered++;
+            }
+            if (issued < opts.queries) {
+                issue();
+            } else if (completed === opts.queries) {
+                finish();
+            }
+        };
+        var transId = ctx.lookup(common.queryName(issued++), getdns.RRTYPE_A, callback);
+        if (Math.random() >= opts.fraction) {
+            return;
+        }
+        var cancel = function() {
+            if (completed >= opts.queries) {
+                return;
+            }
+            cancelStart = process.hrtime();
+            var ok = ctx.cancel(transId);
+            cancelCost.record(common.elapsedMicros(cancelStart) * 1000);
+            cancelCalls++;
+            if (!ok) {
+                // already answered
+                cancelRejected++;
+            }
+        };
+        var point = Math.random();
+        if (point < 1 / 3) {
+            points.sync++;
+            cancel();
+        } else if (point < 2 / 3) {
+            points.tick++;
+            setImmediate(cancel);
+        } else {
+            points.in_flight++;
+            setTimeout(cancel, Math.random() * opts.delay * 2);
+        }
+    };
+
+    var finish = function() {
+        // let closing handles and pending cancel timers go
+        setTimeout(function() {
+            var after = getdns.nativeStats();
+            ctx.destroy();
+            done({
+                name : 'cancel storm',
+                queries : completed,
+                answered : answered,
+                cancelled : cancelled,
+                cancel_calls : cancelCalls,
+                cancel_rejected : cancelRejected,
+                cancel_points : points,
+                cancel_ns : cancelCost.summary(1),
+                cancel_to_callback_ns : delivery.summary(1),
+                leftover_queries : after.live.queries - before.live.queries,
+                leftover_events : after.event_loop.live_events - before.event_loop.live_events
+            });
+        }, opts.delay * 2 + 100);
+    };
+
+    for (var i = 0; i < opts.concurrency && i < opts.queries; ++i) {
+        issue();
+    }
+};
+
+responder.fork({ delay : opts.delay }, function(err, server) {
+    if (err) {
+        throw err;
+    }
+    run(server.port, function(result) {
+        server.close();
+        report.print(result, opts.json);
+    });
+});
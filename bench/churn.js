@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Context churn.  Measures creating and destroying contexts at high
+// rates, both on the native Context (GNContext::New, ApplyOptions and
+// Destroy) and through getdns.createContext, whose destroy is deferred
+// with setImmediate.
+//
+//   node --expose-gc bench/churn.js [--contexts=20000] [--batch=100]
+//       [--options=none|stub] [--json]
+//
+// Reports the cost per context, the fds held while contexts are alive,
+// how long a batch of wrapper destroys took to drain and how many were
+// still waiting when the next batch started.
+
+var fs = require('fs'),
+    common = require('./lib/common'),
+    report = require('./lib/report');
+
+var getdns = common.getdns;
+var Context = require('bindings')('getdns').Context;
+
+var opts = common.parseArgs({
+    contexts : 20000,
+    batch : 100,
+    options : 'stub',
+    json : false
+});
+
+var OPTIONS = {
+    none : {},
+    stub : {
+        stub : true,
+        upstreams : [ [ '127.0.0.1', 53 ], '::1' ],
+        timeout : 2000
+    }
+};
+
+var options = OPTIONS[opts.options];
+if (!options) {
+    throw new Error('unknown options ' + opts.options);
+}
+
+// Count the native destroys that have run, to tell whether the deferred
+// destroys of the createContext wrapper kept up.
+var nativeDestroys = 0;
+var nativeDestroy = Context.prototype.destroy;
+Context.prototype.destroy = function() {
+    nativeDestroys++;
+    return nativeDestroy.apply(this, arguments);
+};
+
+var openFds = function() {
+    try {
+        return fs.readdirSync('/proc/self/fd').length;
+    } catch (e) {
+        return -1;
+    }
+};
+
+var nanos = function(start) {
+    var d = process.hrtime(start);
+    return d[0] * 1e9 + d[1];
+};
+
+var collect = function() {
+    if (global.gc) {
+        global.gc();
+    }
+};
+
+// native create and destroy, timed apart
+var runNative = function(done) {
+    var createNanos = 0, destroyNanos = 0, made = 0;
+    var baseFds = openFds(), peakFds = baseFds;
+    var batch = function() {
+        if (made >= opts.contexts) {
+            collect();
+            return done({
+                name : 'churn native',
+                contexts : made,
+                create_us : createNanos / made / 1000,
+                destroy_us : destroyNanos / made / 1000,
+                contexts_per_sec : made / ((createNanos + destroyNanos) / 1e9),
+                fds_per_context : (peakFds - baseFds) / opts.batch,
+                live_contexts_after_gc : getdns.nativeStats().live.contexts
+            });
+        }
+        var n = Math.min(opts.batch, opts.contexts - made);
+        var contexts = [];
+        var start = process.hrtime();
+        for (var i = 0; i < n; ++i) {
+            contexts.push(new Context(options));
+        }
+        createNanos += nanos(start);
+        peakFds = Math.max(peakFds, openFds());
+        start = process.hrtime();
+        for (i = 0; i < n; ++i) {
+            contexts[i].destroy();
+        }
+        destroyNanos += nanos(start);
+        made += n;
+        setImmediate(batch);
+    };
+    batch();
+};
+
+// createContext and its deferred destroy
+var runWrapper = function(done) {
+    var totalNanos = 0, made = 0, requested = 0;
+    var destroysAtStart = nativeDestroys;
+    var maxLeft = 0, drainNanos = 0;
+    var baseFds = openFds(), peakFds = baseFds;
+    var batch = function() {
+        if (made >= opts.contexts) {
+            collect();
+            return done({
+                name : 'churn createContext',
+                contexts : made,
+                create_destroy_us : totalNanos / made / 1000,
+                contexts_per_sec : made / (totalNanos / 1e9),
+                fds_per_context : (peakFds - baseFds) / opts.batch,
+                destroys_left_per_batch : maxLeft,
+                backlog_drain_us : drainNanos / (made / opts.batch) / 1000,
+                live_contexts_after_gc : getdns.nativeStats().live.contexts
+            });
+        }
+        var n = Math.min(opts.batch, opts.contexts - made);
+        var contexts = [];
+        var start = process.hrtime();
+        for (var i = 0; i < n; ++i) {
+            contexts.push(getdns.createContext(options));
+        }
+        peakFds = Math.max(peakFds, openFds());
+        for (i = 0; i < n; ++i) {
+            contexts[i].destroy();
+            requested++;
+        }
+        totalNanos += nanos(start);
+        made += n;
+        // the deferred destroys are queued ahead of this, so none should
+        // be left when it runs
+        var drainStart = process.hrtime();
+        setImmediate(function() {
+            drainNanos += nanos(drainStart);
+            maxLeft = Math.max(maxLeft,
+                               requested - (nativeDestroys - destroysAtStart));
+            batch();
+        });
+    };
+    batch();
+};
+
+runNative(function(result) {
+    report.print(result, opts.json);
+    runWrapper(function(result) {
+        report.print(result, opts.json);
+    });
+});
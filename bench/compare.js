@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// The same closed loop workload through this binding in stub mode and
+// through node's dns module (c-ares), against the same local responder.
+//
+//   node bench/compare.js [--duration=10] [--concurrency=100] [--lookup]
+//       [--port=0] [--json]
+//
+// dns.resolve4 is pointed at the responder.  dns.lookup goes through
+// getaddrinfo and the system resolver configuration, so it only reaches
+// the responder when that points at it: run the responder on port 53
+// (--port=53, needs privileges) with 127.0.0.1 in /etc/resolv.conf.
+// It is left out unless --lookup is given.
+
+var dns = require('dns'),
+    common = require('./lib/common'),
+    responder = require('./lib/responder'),
+    cpu = require('./lib/cpu'),
+    report = require('./lib/report'),
+    Histogram = require('./lib/histogram');
+
+var getdns = common.getdns;
+
+var opts = common.parseArgs({
+    duration : 10,
+    warmup : 1,
+    concurrency : 100,
+    lookup : false,
+    port : 0,
+    json : false
+});
+
+// A resolver on the responder for dns.resolve4.  Resolver instances are
+// newer than setServers with a port, which is newer than setServers.
+var resolverFor = function(port) {
+    var server = '127.0.0.1:' + port;
+    if (dns.Resolver) {
+        var resolver = new dns.Resolver();
+        resolver.setServers([ server ]);
+        return resolver;
+    }
+    if (port !== 53) {
+        console.error('this node cannot point dns.resolve4 at port ' + port +
+                      ', run with --port=53');
+        process.exit(1);
+    }
+    dns.setServers([ '127.0.0.1' ]);
+    return dns;
+};
+
+// Closed loop over resolve(name, callback) with the shared name set.
+var runLeg = function(name, resolve, done) {
+    var latency = new Histogram();
+    var issued = 0, completed = 0, errors = 0, inFlight = 0;
+    var measuring = false, stopping = false;
+    var startTime, startCpu, elapsed, used;
+
+    var issue = function() {
+        var start = process.hrtime();
+        inFlight++;
+        resolve(common.queryName(issued++), function(err) {
+            inFlight--;
+            if (measuring) {
+                completed++;
+                if (err) {
+                    errors++;
+                }
+                latency.record(common.elapsedMicros(start));
+            }
+            if (!stopping) {
+                issue();
+            } else if (inFlight === 0) {
+                done({
+                    name : name,
+                    queries : completed,
+                    errors : errors,
+                    qps : completed / elapsed,
+                    cpu_us_per_query : completed ? (used.user + used.system) / completed : 0,
+                    latency_ms : latency.summary(1000)
+                });
+            }
+        });
+    };
+
+    for (var i = 0; i < opts.concurrency; ++i) {
+        issue();
+    }
+    setTimeout(function() {
+        measuring = true;
+        startTime = process.hrtime();
+        startCpu = cpu.usage();
+        setTimeout(function() {
+            measuring = false;
+            stopping = true;
+            elapsed = common.elapsedMicros(startTime) / 1e6;
+            used = cpu.since(startCpu);
+        }, opts.duration * 1000);
+    }, opts.warmup * 1000);
+};
+
+var legs = function(port) {
+    var ctx = common.stubContext(port, {
+        dns_transport : getdns.TRANSPORT_UDP_ONLY
+    });
+    var resolver = resolverFor(port);
+    var list = [
+        { name : 'getdns lookup', resolve : function(name, cb) {
+            ctx.lookup(name, getdns.RRTYPE_A, cb);
+        }, done : function() {
+            ctx.destroy();
+        } },
+        { name : 'dns.resolve4', resolve : function(name, cb) {
+            resolver.resolve4(name, cb);
+        } }
+    ];
+    if (opts.lookup) {
+        list.push({ name : 'dns.lookup', resolve : function(name, cb) {
+            dns.lookup(name, 4, cb);
+        } });
+    }
+    return list;
+};
+
+// ratio of each leg to the binding, > 1 means the other leg is higher
+var compare = function(results) {
+    var base = results[0];
+    results.slice(1).forEach(function(r) {
+        report.print({
+            name : r.name + ' vs ' + base.name,
+            qps_ratio : r.qps / base.qps,
+            cpu_ratio : r.cpu_us_per_query / base.cpu_us_per_query,
+            p50_ratio : r.latency_ms.p50 / base.latency_ms.p50,
+            p99_ratio : r.latency_ms.p99 / base.latency_ms.p99
+        }, opts.json);
+    });
+};
+
+responder.fork({ port : opts.port }, function(err, server) {
+    if (err) {
+        throw err;
+    }
+    var list = legs(server.port);
+    var results = [];
+    var next = function(i) {
+        if (i === list.length) {
+            server.close();
+            return compare(results);
+        }
+        runLeg(list[i].name, list[i].resolve, function(result) {
+            if (list[i].done) {
+                list[i].done();
+            }
+            report.print(result, opts.json);
+            results.push(result);
+            next(i + 1);
+        });
+    };
+    next(0);
+});
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Conversion microbenchmark.  Times GNUtil::convertToJSObj over the
+// response fixtures in bench/fixtures with no network involved.  Needs
+// the native benchmark module:
+//
+//   node-gyp rebuild -- -Dbuild_bench=true
+//   node bench/convert.js [--iterations=20000] [--fixture=name] [--json]
+//
+// Per fixture it reports ns per response, the JS values created per
+// response, the getdns allocations made per response and the time spent
+// in GC while converting.
+
+var common = require('./lib/common'),
+    report = require('./lib/report'),
+    fixtures = require('./fixtures');
+
+var opts = common.parseArgs({
+    iterations : 20000,
+    warmup : 1000,
+    fixture : '',
+    json : false
+});
+
+var bench;
+try {
+    bench = require('bindings')('getdns_bench');
+} catch (e) {
+    console.error('getdns_bench is not built, run node-gyp rebuild -- -Dbuild_bench=true');
+    process.exit(1);
+}
+
+var all = fixtures.load();
+var names = Object.keys(all).filter(function(name) {
+    return !opts.fixture || name === opts.fixture;
+});
+if (names.length === 0) {
+    console.error('no fixture named ' + opts.fixture);
+    process.exit(1);
+}
+var responses = names.map(function(name) {
+    return all[name];
+});
+
+// let the conversion code get optimized and the heap settle
+bench.convert(responses, opts.warmup);
+
+var results = bench.convert(responses, opts.iterations);
+names.forEach(function(name, i) {
+    var r = results[i];
+    report.print({
+        name : 'convert ' + name,
+        iterations : r.iterations,
+        ns_per_response : r.nanos / r.iterations,
+        js_values_per_response : (r.nodes + r.strings + r.buffers) / r.iterations,
+        buffers_per_response : r.buffers / r.iterations,
+        binary_bytes_per_response : r.binary_bytes / r.iterations,
+        native_allocations_per_response : r.native_allocations / r.iterations,
+        gc_ms : r.gc_nanos / 1e6,
+        gc_count : r.gc_count,
+        gc_share : r.nanos ? r.gc_nanos / r.nanos : 0
+    }, opts.json);
+});
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Entry cost of lookup and the helper lookups: argument checks, name
+// conversion, extension conversion, CallbackData and the transaction id
+// Buffer.  Runs the Context from the native benchmark module, where the
+// getdns query functions are stubbed out and never reach the network,
+// so only the binding is measured.
+//
+//   node-gyp rebuild -- -Dbuild_bench=true
+//   node bench/entry.js [--calls=200000] [--batch=1000] [--case=name] [--json]
+//
+// The held lookups are completed in batches.  The cost of completing
+// them, callback into JS included, is reported as callback_ns.
+
+var common = require('./lib/common'),
+    report = require('./lib/report');
+
+var opts = common.parseArgs({
+    calls : 200000,
+    batch : 1000,
+    warmup : 20000,
+    case : '',
+    json : false
+});
+
+var bench;
+try {
+    bench = require('bindings')('getdns_bench');
+} catch (e) {
+    console.error('getdns_bench is not built, run node-gyp rebuild -- -Dbuild_bench=true');
+    process.exit(1);
+}
+
+var ctx = new bench.Context({});
+var noop = function() { };
+
+// typical extension objects
+var DNSSEC_EXT = {
+    dnssec_return_status : true
+};
+var ADDRESS_EXT = {
+    return_both_v4_and_v6 : true,
+    add_opt_parameters : { maximum_udp_payload_size : 1232 }
+};
+var BINDING_EXT = {
+    tenant : 'bench',
+    priority : 1,
+    dnssec_return_status : true
+};
+
+var CASES = {
+    lookup : function(name) {
+        return ctx.lookup(name, bench.constants.RRTYPE_A, noop);
+    },
+    lookup_ext : function(name) {
+        return ctx.lookup(name, bench.constants.RRTYPE_A, DNSSEC_EXT, noop);
+    },
+    lookup_binding_ext : function(name) {
+        return ctx.lookup(name, bench.constants.RRTYPE_A, BINDING_EXT, noop);
+    },
+    getAddress : function(name) {
+        return ctx.getAddress(name, noop);
+    },
+    getAddress_ext : function(name) {
+        return ctx.getAddress(name, ADDRESS_EXT, noop);
+    },
+    getHostname : function(name) {
+        return ctx.getHostname('192.0.2.1', noop);
+    },
+    getService : function(name) {
+        return ctx.getService('_sip._udp.' + name, noop);
+    }
+};
+
+var names = [];
+for (var i = 0; i < opts.batch; ++i) {
+    names.push(common.queryName(i));
+}
+
+// time calls in batches, completing the held lookups in between
+var run = function(fn, calls) {
+    var callNanos = 0, flushNanos = 0, done = 0;
+    while (done < calls) {
+        var n = Math.min(opts.batch, calls - done);
+        var start = process.hrtime();
+        for (var j = 0; j < n; ++j) {
+            fn(names[j]);
+        }
+        var d = process.hrtime(start);
+        callNanos += d[0] * 1e9 + d[1];
+        start = process.hrtime();
+        bench.flush();
+        d = process.hrtime(start);
+        flushNanos += d[0] * 1e9 + d[1];
+        done += n;
+    }
+    return {
+        call_ns : callNanos / calls,
+        callback_ns : flushNanos / calls
+    };
+};
+
+Object.keys(CASES).filter(function(name) {
+    return !opts.case || name === opts.case;
+}).forEach(function(name) {
+    run(CASES[name], opts.warmup);
+    var result = run(CASES[name], opts.calls);
+    report.print({
+        name : 'entry ' + name,
+        calls : opts.calls,
+        call_ns : result.call_ns,
+        callback_ns : result.callback_ns
+    }, opts.json);
+});
+
+ctx.destroy();
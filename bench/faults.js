@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Behaviour under faults.  Runs lookups against the fault injecting
+// responder (bench/lib/faulty.js) for each scenario in turn and reports
+// how they complete and how long they take:
+//
+//   baseline  - no faults
+//   latency   - answers held back past the timeout
+//   loss      - a share of the queries dropped
+//   tc        - every UDP answer truncated, so getdns retries over TCP
+//   oversize  - answers too large for UDP
+//   servfail  - half the answers SERVFAIL
+//   reset     - truncated and TCP connections reset
+//
+//   node bench/faults.js [--queries=200] [--concurrency=20]
+//       [--timeout=100] [--scenario=name] [--seed=1] [--json]
+//
+// The faults per name are in bench/zones/faults.conf.
+
+var common = require('./lib/common'),
+    faulty = require('./lib/faulty'),
+    report = require('./lib/report'),
+    Histogram = require('./lib/histogram');
+
+var getdns = common.getdns;
+
+var opts = common.parseArgs({
+    queries : 200,
+    concurrency : 20,
+    timeout : 100,
+    scenario : '',
+    seed : 1,
+    json : false
+});
+
+var SCENARIOS = [
+    { name : 'baseline', qname : 'ok.bench.example', type : 'RRTYPE_A' },
+    { name : 'latency', qname : 'slow.bench.example', type : 'RRTYPE_A' },
+    { name : 'loss', qname : 'lossy.bench.example', type : 'RRTYPE_A' },
+    { name : 'tc', qname : 'truncated.bench.example', type : 'RRTYPE_A' },
+    { name : 'oversize', qname : 'big.bench.example', type : 'RRTYPE_TXT' },
+    { name : 'servfail', qname : 'broken.bench.example', type : 'RRTYPE_A' },
+    { name : 'reset', qname : 'reset.bench.example', type : 'RRTYPE_A' }
+];
+
+// How a lookup completed
+var outcome = function(err, result) {
+    if (err) {
+        if (err.code === getdns.CALLBACK_TIMEOUT) {
+            return 'timeout';
+        }
+        return 'error_' + err.code;
+    }
+    if (result.status === getdns.RESPSTATUS_ALL_TIMEOUT) {
+        return 'timeout';
+    }
+    var reply = result.replies_tree && result.replies_tree[0];
+    if (!reply) {
+        return 'no_reply';
+    }
+    if (reply.header.rcode !== getdns.RCODE_NOERROR) {
+        return 'rcode_' + reply.header.rcode;
+    }
+    return reply.answer.length ? 'answered' : 'nodata';
+};
+
+var runScenario = function(port, scenario, done) {
+    var ctx = common.stubContext(port, { timeout : opts.timeout });
+    var latency = new Histogram();
+    var outcomes = {};
+    var issued = 0, completed = 0;
+
+    var issue = function() {
+        var start = process.hrtime();
+        issued++;
+        ctx.lookup(scenario.qname, getdns[scenario.type], function(err, result) {
+            latency.record(common.elapsedMicros(start));
+            var o = outcome(err, result);
+            outcomes[o] = (outcomes[o] || 0) + 1;
+            completed++;
+            if (issued < opts.queries) {
+                issue();
+            } else if (completed === opts.queries) {
+                setImmediate(function() {
+                    ctx.destroy();
+                    done({
+                        queries : completed,
+                        outcomes : outcomes,
+                        latency_ms : latency.summary(1000)
+                    });
+                });
+            }
+        });
+    };
+
+    for (var i = 0; i < opts.concurrency && i < opts.queries; ++i) {
+        issue();
+    }
+};
+
+var scenarios = SCENARIOS.filter(function(s) {
+    return !opts.scenario || s.name === opts.scenario;
+});
+if (!scenarios.length) {
+    throw new Error('unknown scenario ' + opts.scenario);
+}
+
+faulty.spawn({ seed : opts.seed }, function(err, server) {
+    if (err) {
+        throw err;
+    }
+    var result = {
+        name : 'faults',
+        timeout_ms : opts.timeout,
+        scenarios : {}
+    };
+    var next = function(i) {
+        if (i === scenarios.length) {
+            server.close();
+            return report.print(result, opts.json);
+        }
+        runScenario(server.port, scenarios[i], function(r) {
+            result.scenarios[scenarios[i].name] = r;
+            next(i + 1);
+        });
+    };
+    next(0);
+});
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Response fixtures for the conversion benchmarks, in the shape getdns
+// hands to the binding: dnames and addresses are wire format Buffers so
+// converting them takes the same paths as a live response.
+//
+// The built in fixtures are synthesized so the benchmarks need no
+// network.  Responses recorded with record.js are saved as *.json next
+// to this file and loaded as well.
+
+var fs = require('fs'),
+    path = require('path');
+
+// constants from getdns.h, kept here so fixtures load without the module
+var RRTYPE_A = 1,
+    RRTYPE_MX = 15,
+    RRTYPE_TXT = 16,
+    RRTYPE_AAAA = 28,
+    RRTYPE_SRV = 33,
+    RRTYPE_DS = 43,
+    RRTYPE_RRSIG = 46,
+    RRTYPE_DNSKEY = 48,
+    CLASS_IN = 1,
+    NAMETYPE_DNS = 800,
+    RESPSTATUS_GOOD = 900,
+    DNSSEC_SECURE = 400;
+
+// deterministic filler so runs convert the same bytes
+var seed = 1;
+var bytes = function(n) {
+    var buf = new Buffer(n);
+    for (var i = 0; i < n; ++i) {
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+        buf[i] = seed >> 16;
+    }
+    return buf;
+};
+
+var dname = function(name) {
+    var labels = name.split('.').filter(function(l) { return l.length > 0; });
+    var parts = [];
+    labels.forEach(function(l) {
+        parts.push(new Buffer([l.length]));
+        parts.push(new Buffer(l, 'ascii'));
+    });
+    parts.push(new Buffer([0]));
+    return Buffer.concat(parts);
+};
+
+var ipv4 = function(s) {
+    return new Buffer(s.split('.').map(Number));
+};
+
+var ipv6 = function(s) {
+    // full or with a single ::
+    var halves = s.split('::');
+    var head = halves[0] ? halves[0].split(':') : [];
+    var tail = halves.length > 1 && halves[1] ? halves[1].split(':') : [];
+    var groups = head.slice();
+    while (groups.length + tail.length < 8) {
+        groups.push('0');
+    }
+    groups = groups.concat(tail);
+    var buf = new Buffer(16);
+    groups.forEach(function(g, i) {
+        buf.writeUInt16BE(parseInt(g, 16), i * 2);
+    });
+    return buf;
+};
+
+var rr = function(name, type, rdata) {
+    rdata.rdata_raw = bytes(rdata._rawSize || 16);
+    delete rdata._rawSize;
+    return {
+        name : dname(name),
+        type : type,
+        class : CLASS_IN,
+        ttl : 300,
+        rdata : rdata
+    };
+};
+
+var rrsig = function(name, covered) {
+    return rr(name, RRTYPE_RRSIG, {
+        type_covered : covered,
+        algorithm : 8,
+        labels : name.split('.').length,
+        original_ttl : 300,
+        signature_expiration : 1420070400,
+        signature_inception : 1417392000,
+        key_tag : 12345,
+        signers_name : dname(name.split('.').slice(-2).join('.')),
+        signature : bytes(256),
+        _rawSize : 300
+    });
+};
+
+var dnskey = function(name, flags) {
+    return rr(name, RRTYPE_DNSKEY, {
+        flags : flags,
+        protocol : 3,
+        algorithm : 8,
+        public_key : bytes(260),
+        _rawSize : 264
+    });
+};
+
+var ds = function(name) {
+    return rr(name, RRTYPE_DS, {
+        key_tag : 12345,
+        algorithm : 8,
+        digest_type : 2,
+        digest : bytes(32),
+        _rawSize : 36
+    });
+};
+
+// Wrap answers in a full response dict
+var response = function(qname, qtype, answers, extra) {
+    var addresses = [];
+    answers.forEach(function(a) {
+        if (a.type === RRTYPE_A) {
+            addresses.push({ address_type : 'IPv4', address_data : a.rdata.ipv4_address });
+        } else if (a.type === RRTYPE_AAAA) {
+            addresses.push({ address_type : 'IPv6', address_data : a.rdata.ipv6_address });
+        }
+    });
+    var reply = {
+        header : {
+            id : 0, qr : 1, opcode : 0, aa : 0, tc : 0, rd : 1, ra : 1,
+            z : 0, ad : 0, cd : 0, rcode : 0, qdcount : 1,
+            ancount : answers.length, nscount : 0, arcount : 0
+        },
+        question : { qname : dname(qname), qtype : qtype, qclass : CLASS_IN },
+        answer : answers,
+        authority : [],
+        additional : [],
+        canonical_name : dname(qname),
+        answer_type : NAMETYPE_DNS
+    };
+    var result = {
+        answer_type : NAMETYPE_DNS,
+        canonical_name : dname(qname),
+        just_address_answers : addresses,
+        replies_full : [ bytes(64 + answers.length * 32) ],
+        replies_tree : [ reply ],
+        status : RESPSTATUS_GOOD
+    };
+    Object.keys(extra || {}).forEach(function(k) {
+        if (k === 'reply') {
+            Object.keys(extra.reply).forEach(function(rk) {
+                reply[rk] = extra.reply[rk];
+            });
+        } else {
+            result[k] = extra[k];
+        }
+    });
+    return result;
+};
+
+var range = function(n, fn) {
+    var out = [];
+    for (var i = 0; i < n; ++i) {
+        out.push(fn(i));
+    }
+    return out;
+};
+
+var BUILDERS = {
+    a : function() {
+        return response('www.example.com', RRTYPE_A, [
+            rr('www.example.com', RRTYPE_A, { ipv4_address : ipv4('93.184.216.34') }),
+            rr('www.example.com', RRTYPE_A, { ipv4_address : ipv4('93.184.216.35') })
+        ]);
+    },
+    aaaa : function() {
+        return response('www.example.com', RRTYPE_AAAA, [
+            rr('www.example.com', RRTYPE_AAAA, { ipv6_address : ipv6('2606:2800:220:1::248') })
+        ]);
+    },
+    mx : function() {
+        return response('example.com', RRTYPE_MX, range(5, function(i) {
+            return rr('example.com', RRTYPE_MX, {
+                preference : (i + 1) * 10,
+                exchange : dname('mx' + i + '.mail.example.com')
+            });
+        }));
+    },
+    txt_heavy : function() {
+        return response('example.com', RRTYPE_TXT, range(20, function(i) {
+            return rr('example.com', RRTYPE_TXT, {
+                txt_strings : range(4, function(j) {
+                    return 'v=spf1 include:_spf' + i + '-' + j +
+                           '.example.com ip4:192.0.2.0/24 ~all';
+                }),
+                _rawSize : 240
+            });
+        }));
+    },
+    dnssec_chain : function() {
+        var name = 'www.example.com';
+        var answers = [
+            rr(name, RRTYPE_A, { ipv4_address : ipv4('93.184.216.34') }),
+            rrsig(name, RRTYPE_A)
+        ];
+        return response(name, RRTYPE_A, answers, {
+            reply : { dnssec_status : DNSSEC_SECURE },
+            validation_chain : [
+                dnskey('example.com', 256), dnskey('example.com', 257),
+                rrsig('example.com', RRTYPE_DNSKEY),
+                ds('example.com'), rrsig('example.com', RRTYPE_DS),
+                dnskey('com', 256), dnskey('com', 257),
+                rrsig('com', RRTYPE_DNSKEY),
+                ds('com'), rrsig('com', RRTYPE_DS),
+                dnskey('.', 256), dnskey('.', 257),
+                rrsig('.', RRTYPE_DNSKEY)
+            ]
+        });
+    },
+    srv_large : function() {
+        return response('_sip._udp.example.com', RRTYPE_SRV, range(64, function(i) {
+            return rr('_sip._udp.example.com', RRTYPE_SRV, {
+                priority : i % 4,
+                weight : i,
+                port : 5060,
+                target : dname('sip' + i + '.example.com')
+            });
+        }));
+    }
+};
+
+// JSON encoding with Buffers as { "$bin" : hex }
+var encode = function(value) {
+    return JSON.stringify(value, function(k, v) {
+        if (v && v.type === 'Buffer' && Array.isArray(v.data)) {
+            return { $bin : new Buffer(v.data).toString('hex') };
+        }
+        return v;
+    }, 1);
+};
+
+var decode = function(text) {
+    return JSON.parse(text, function(k, v) {
+        if (v && typeof v.$bin === 'string') {
+            return new Buffer(v.$bin, 'hex');
+        }
+        return v;
+    });
+};
+
+// All fixtures as { name : response }
+var load = function() {
+    var fixtures = {};
+    Object.keys(BUILDERS).forEach(function(name) {
+        seed = 1;
+        fixtures[name] = BUILDERS[name]();
+    });
+    fs.readdirSync(__dirname).forEach(function(file) {
+        if (path.extname(file) === '.json') {
+            fixtures[path.basename(file, '.json')] =
+                decode(fs.readFileSync(path.join(__dirname, file), 'utf8'));
+        }
+    });
+    return fixtures;
+};
+
+module.exports = {
+    load : load,
+    encode : encode,
+    decode : decode,
+    dname : dname,
+    ipv4 : ipv4,
+    ipv6 : ipv6
+};
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Record live responses as conversion fixtures.  Needs network access.
+//
+//   node bench/fixtures/record.js <name> <fixture> [rrtype] [--dnssec]
+//
+// e.g. node bench/fixtures/record.js getdnsapi.net getdnsapi_a A --dnssec
+//
+// The binding has already turned dnames and addresses into strings, so
+// they are put back into wire format to make the fixture convert the way
+// the live response did.
+
+var fs = require('fs'),
+    path = require('path'),
+    getdns = require('../../getdns'),
+    fixtures = require('./index');
+
+// rdata and reply fields holding dnames
+var DNAME_KEYS = [
+    'name', 'qname', 'canonical_name', 'exchange', 'target', 'nsdname',
+    'ptrdname', 'cname', 'signers_name', 'next_domain_name', 'mname',
+    'rname'
+];
+
+var toWire = function(value, key) {
+    if (Array.isArray(value)) {
+        return value.map(function(v) {
+            return toWire(v, null);
+        });
+    }
+    if (value && typeof value === 'object' && !Buffer.isBuffer(value)) {
+        var out = {};
+        Object.keys(value).forEach(function(k) {
+            out[k] = toWire(value[k], k);
+        });
+        return out;
+    }
+    if (typeof value !== 'string') {
+        return value;
+    }
+    if (DNAME_KEYS.indexOf(key) >= 0) {
+        return fixtures.dname(value);
+    }
+    if (key === 'ipv4_address') {
+        return fixtures.ipv4(value);
+    }
+    if (key === 'ipv6_address') {
+        return fixtures.ipv6(value);
+    }
+    return value;
+};
+
+// just_address_answers entries come back as strings
+var restoreAddresses = function(response) {
+    if (Array.isArray(response.just_address_answers)) {
+        response.just_address_answers = response.just_address_answers.map(function(a) {
+            if (typeof a !== 'string') {
+                return a;
+            }
+            var v6 = a.indexOf(':') >= 0;
+            return {
+                address_type : v6 ? 'IPv6' : 'IPv4',
+                address_data : v6 ? fixtures.ipv6(a) : fixtures.ipv4(a)
+            };
+        });
+    }
+    return response;
+};
+
+var args = process.argv.slice(2).filter(function(a) {
+    return a !== '--dnssec';
+});
+var dnssec = process.argv.indexOf('--dnssec') >= 0;
+if (args.length < 2) {
+    console.error('usage: record.js <name> <fixture> [rrtype] [--dnssec]');
+    process.exit(1);
+}
+
+var type = getdns['RRTYPE_' + (args[2] || 'A').toUpperCase()];
+if (type === undefined) {
+    console.error('unknown rrtype ' + args[2]);
+    process.exit(1);
+}
+
+var extensions = {};
+if (dnssec) {
+    extensions.dnssec_return_validation_chain = true;
+}
+
+var ctx = getdns.createContext({ stub : true });
+ctx.lookup(args[0], type, extensions, function(err, result) {
+    ctx.destroy();
+    if (err) {
+        console.error(err);
+        // after the deferred destroy
+        setImmediate(function() {
+            process.exit(1);
+        });
+        return;
+    }
+    var file = path.join(__dirname, args[1] + '.json');
+    fs.writeFileSync(file, fixtures.encode(restoreAddresses(toWire(result, null))));
+    console.log('wrote ' + file);
+});
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// The process measured by bench/startup.js.  Times require('getdns'),
+// the first context and its first lookup against the responder on the
+// port given, and writes them as a JSON line.  It requires nothing
+// before getdns so the require is timed cold.
+//
+//   node bench/lib/coldstart.js port
+
+var start = process.hrtime();
+var getdns = require('../../getdns');
+
+var millis = function(start) {
+    var d = process.hrtime(start);
+    return d[0] * 1e3 + d[1] / 1e6;
+};
+
+var required = millis(start);
+start = process.hrtime();
+var ctx = getdns.createContext({
+    stub : true,
+    upstreams : [ [ '127.0.0.1', Number(process.argv[2]) ] ]
+});
+var created = millis(start);
+start = process.hrtime();
+ctx.lookup('startup.bench.example', getdns.RRTYPE_A, function(err, result) {
+    var looked = millis(start);
+    ctx.destroy();
+    process.stdout.write(JSON.stringify({
+        require_ms : required,
+        context_ms : created,
+        first_lookup_ms : looked,
+        error : err ? err.code : 0
+    }) + '\n');
+});
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Helpers shared by the benchmarks
+
+var getdns = require('../../getdns');
+
+// Parse --name=value and --flag arguments over the defaults.  Values are
+// converted to the type of the default.
+var parseArgs = function(defaults, argv) {
+    var opts = {};
+    Object.keys(defaults).forEach(function(k) {
+        opts[k] = defaults[k];
+    });
+    (argv || process.argv.slice(2)).forEach(function(arg) {
+        var m = /^--([^=]+)(?:=(.*))?$/.exec(arg);
+        if (!m) {
+            throw new Error('unexpected argument ' + arg);
+        }
+        var name = m[1].replace(/-/g, '_');
+        var value = m[2];
+        if (!(name in defaults)) {
+            throw new Error('unknown option --' + m[1]);
+        }
+        if (typeof defaults[name] === 'boolean') {
+            opts[name] = value === undefined || value === 'true';
+        } else if (typeof defaults[name] === 'number') {
+            opts[name] = Number(value);
+            if (isNaN(opts[name])) {
+                throw new Error('--' + m[1] + ' needs a number');
+            }
+        } else {
+            opts[name] = value;
+        }
+    });
+    return opts;
+};
+
+// A stub context pointed at a local responder
+var stubContext = function(port, opts) {
+    var options = {
+        stub : true,
+        upstreams : [ [ '127.0.0.1', port ] ],
+        timeout : 2000
+    };
+    Object.keys(opts || {}).forEach(function(k) {
+        options[k] = opts[k];
+    });
+    return getdns.createContext(options);
+};
+
+// Names for the nth query.  Unique names keep any cache from answering.
+var queryName = function(n) {
+    return 'q' + n + '.bench.example';
+};
+
+// hrtime difference in micros
+var elapsedMicros = function(start) {
+    var d = process.hrtime(start);
+    return d[0] * 1e6 + d[1] / 1e3;
+};
+
+module.exports = {
+    getdns : getdns,
+    parseArgs : parseArgs,
+    stubContext : stubContext,
+    queryName : queryName,
+    elapsedMicros : elapsedMicros
+};
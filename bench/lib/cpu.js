@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// CPU time used by this process in micros, { user, system }.
+// process.cpuUsage is not there on older node, so fall back to
+// /proc/self/stat there.
+
+var fs = require('fs');
+
+// USER_HZ, the unit of the times in /proc/self/stat
+var CLOCK_TICK_MICROS = 10000;
+
+var fromProc = function() {
+    try {
+        var stat = fs.readFileSync('/proc/self/stat', 'ascii');
+        // skip past the command name which may contain spaces
+        var fields = stat.slice(stat.lastIndexOf(')') + 2).split(' ');
+        // utime and stime are fields 14 and 15, the 12th and 13th here
+        return {
+            user : parseInt(fields[11], 10) * CLOCK_TICK_MICROS,
+            system : parseInt(fields[12], 10) * CLOCK_TICK_MICROS
+        };
+    } catch (e) {
+        return null;
+    }
+};
+
+var usage = function() {
+    if (process.cpuUsage) {
+        return process.cpuUsage();
+    }
+    return fromProc() || { user : 0, system : 0 };
+};
+
+// CPU used since an earlier usage()
+var since = function(start) {
+    var now = usage();
+    return {
+        user : now.user - start.user,
+        system : now.system - start.system
+    };
+};
+
+module.exports = {
+    usage : usage,
+    since : since
+};
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Starts the fault injecting responder (bench/native/GNResponder.cpp)
+// in its own process.  Build it first with
+//
+//   node-gyp rebuild -- -Dbuild_bench=true
+//
+// Options: zone and faults - file names, defaulting to the files in
+// bench/zones, address, port and seed.  Calls back with the port it
+// listens on and a close function.
+
+var child_process = require('child_process'),
+    fs = require('fs'),
+    path = require('path');
+
+var ROOT = path.join(__dirname, '..', '..');
+
+var BINARY = [
+    path.join(ROOT, 'build', 'Release', 'gn_responder'),
+    path.join(ROOT, 'build', 'Debug', 'gn_responder')
+];
+
+var binary = function() {
+    for (var i = 0; i < BINARY.length; ++i) {
+        if (fs.existsSync(BINARY[i])) {
+            return BINARY[i];
+        }
+    }
+    return null;
+};
+
+var spawn = function(opts, callback) {
+    opts = opts || {};
+    var exe = binary();
+    if (!exe) {
+        return callback(new Error('gn_responder not built, ' +
+                                  'run node-gyp rebuild -- -Dbuild_bench=true'));
+    }
+    var args = [
+        '-z', opts.zone || path.join(ROOT, 'bench', 'zones', 'bench.zone'),
+        '-f', opts.faults || path.join(ROOT, 'bench', 'zones', 'faults.conf'),
+        '-a', opts.address || '127.0.0.1'
+    ];
+    if (opts.port) {
+        args.push('-p', String(opts.port));
+    }
+    if (opts.seed !== undefined) {
+        args.push('-s', String(opts.seed));
+    }
+    var child = child_process.spawn(exe, args, {
+        stdio : [ 'ignore', 'pipe', 'inherit' ]
+    });
+    var output = '', started = false;
+    child.stdout.setEncoding('utf8');
+    child.stdout.on('data', function(data) {
+        output += data;
+        var m = /listening on \S+#(\d+)/.exec(output);
+        if (m && !started) {
+            started = true;
+            callback(null, {
+                port : Number(m[1]),
+                close : function() {
+                    child.kill('SIGTERM');
+                }
+            });
+        }
+    });
+    child.on('exit', function(code) {
+        if (!started) {
+            started = true;
+            callback(new Error('gn_responder exited with ' + code));
+        }
+    });
+};
+
+module.exports = {
+    binary : binary,
+    spawn : spawn
+};
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Log-linear latency histogram, the same bucketing as the native one
+// behind context.stats(): values below 32 are exact and every power of two
+// above that is split into 16 buckets, so any recorded value is off by at
+// most 1/16th.  Record in whatever integer unit suits, usually micros.
+
+var SUB_BUCKET_BITS = 5,
+    SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+    HALF_SUB_BUCKETS = SUB_BUCKETS >> 1,
+    NUM_BUCKETS = SUB_BUCKETS + HALF_SUB_BUCKETS * (53 - SUB_BUCKET_BITS);
+
+var bitLength = function(v) {
+    var bits = 0;
+    while (v >= 1) {
+        v = Math.floor(v / 2);
+        bits++;
+    }
+    return bits;
+};
+
+var bucketIndex = function(v) {
+    if (v < SUB_BUCKETS) {
+        return v;
+    }
+    var shift = bitLength(v) - SUB_BUCKET_BITS;
+    var sub = Math.floor(v / Math.pow(2, shift));
+    return SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + (sub - HALF_SUB_BUCKETS);
+};
+
+// highest value that lands in the bucket
+var bucketHighest = function(index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    var shift = Math.floor((index - SUB_BUCKETS) / HALF_SUB_BUCKETS) + 1;
+    var sub = (index - SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+    return (sub + 1) * Math.pow(2, shift) - 1;
+};
+
+var Histogram = function() {
+    this.reset();
+};
+
+Histogram.prototype.reset = function() {
+    this.counts = [];
+    for (var i = 0; i < NUM_BUCKETS; ++i) {
+        this.counts.push(0);
+    }
+    this.count = 0;
+    this.sum = 0;
+    this.min = 0;
+    this.max = 0;
+};
+
+Histogram.prototype.record = function(v) {
+    v = Math.max(0, Math.round(v));
+    this.counts[bucketIndex(v)]++;
+    if (this.count === 0 || v < this.min) {
+        this.min = v;
+    }
+    if (v > this.max) {
+        this.max = v;
+    }
+    this.count++;
+    this.sum += v;
+};
+
+// add the values recorded in another histogram
+Histogram.prototype.merge = function(other) {
+    if (other.count === 0) {
+        return;
+    }
+    for (var i = 0; i < NUM_BUCKETS; ++i) {
+        this.counts[i] += other.counts[i];
+    }
+    if (this.count === 0 || other.min < this.min) {
+        this.min = other.min;
+    }
+    this.max = Math.max(this.max, other.max);
+    this.count += other.count;
+    this.sum += other.sum;
+};
+
+Histogram.prototype.mean = function() {
+    return this.count ? this.sum / this.count : 0;
+};
+
+// p in [0, 100]
+Histogram.prototype.percentile = function(p) {
+    if (this.count === 0) {
+        return 0;
+    }
+    var rank = Math.max(1, Math.ceil(this.count * p / 100));
+    var seen = 0;
+    for (var i = 0; i < NUM_BUCKETS; ++i) {
+        seen += this.counts[i];
+        if (seen >= rank) {
+            return Math.min(bucketHighest(i), this.max);
+        }
+    }
+    return this.max;
+};
+
+// summary in the shape of the native stats, divided by scale
+Histogram.prototype.summary = function(scale) {
+    scale = scale || 1;
+    var s = function(v) { return v / scale; };
+    return {
+        count : this.count,
+        min : s(this.min),
+        max : s(this.max),
+        mean : s(this.mean()),
+        p50 : s(this.percentile(50)),
+        p90 : s(this.percentile(90)),
+        p99 : s(this.percentile(99)),
+        p999 : s(this.percentile(99.9))
+    };
+};
+
+// Cumulative distribution in the HdrHistogram text format
+// (Value Percentile TotalCount 1/(1-Percentile)) for plotting
+Histogram.prototype.toHdrText = function(scale) {
+    scale = scale || 1;
+    var lines = [
+        '       Value     Percentile TotalCount 1/(1-Percentile)',
+        ''
+    ];
+    var seen = 0;
+    for (var i = 0; i < NUM_BUCKETS; ++i) {
+        if (this.counts[i] === 0) {
+            continue;
+        }
+        seen += this.counts[i];
+        var pct = seen / this.count;
+        var inv = pct < 1 ? (1 / (1 - pct)).toFixed(2) : 'inf';
+        lines.push([
+            pad((Math.min(bucketHighest(i), this.max) / scale).toFixed(3), 12),
+            pad(pct.toFixed(12), 14),
+            pad(String(seen), 10),
+            pad(inv, 14)
+        ].join(' '));
+    }
+    lines.push('#[Mean    = ' + (this.mean() / scale).toFixed(3) +
+               ', Max     = ' + (this.max / scale).toFixed(3) + ']');
+    lines.push('#[Total count    = ' + this.count + ']');
+    return lines.join('\n') + '\n';
+};
+
+var pad = function(s, width) {
+    while (s.length < width) {
+        s = ' ' + s;
+    }
+    return s;
+};
+
+module.exports = Histogram;
+module.exports.bucketIndex = bucketIndex;
+module.exports.bucketHighest = bucketHighest;
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Query sources for bench/replay.js.  Both return the queries as
+// [ { name, type, time } ] in time order, time in seconds from the first.
+//
+// pcap - classic libpcap files (not pcapng) with Ethernet, Linux cooked,
+//   BSD loopback or raw IP link layers.  Every UDP DNS query to port is
+//   taken, IPv4 or IPv6; responses, fragments and TCP are skipped.
+// log - one query per line, "name type timestamp", type a mnemonic
+//   (A, AAAA, MX, ...) or a number and timestamp in seconds.  Blank lines
+//   and lines starting with # are skipped.
+
+var fs = require('fs');
+
+var PCAP_MAGIC = 0xa1b2c3d4,
+    PCAP_MAGIC_NS = 0xa1b23c4d;
+
+var LINKTYPE_NULL = 0,
+    LINKTYPE_ETHERNET = 1,
+    LINKTYPE_RAW = 101,
+    LINKTYPE_LINUX_SLL = 113,
+    LINKTYPE_IPV4 = 228,
+    LINKTYPE_IPV6 = 229;
+
+var ETHERTYPE_IPV4 = 0x0800,
+    ETHERTYPE_IPV6 = 0x86dd,
+    ETHERTYPE_VLAN = 0x8100,
+    PROTO_UDP = 17;
+
+// offset of the IP header in a frame or -1 to skip it
+var ipOffset = function(linkType, frame) {
+    var type, offset;
+    switch (linkType) {
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+        case LINKTYPE_IPV6:
+            return 0;
+        case LINKTYPE_NULL:
+            // address family in host order, the IP version tells
+            return frame.length > 4 ? 4 : -1;
+        case LINKTYPE_LINUX_SLL:
+            if (frame.length < 16) {
+                return -1;
+            }
+            type = frame.readUInt16BE(14);
+            offset = 16;
+            break;
+        case LINKTYPE_ETHERNET:
+            if (frame.length < 14) {
+                return -1;
+            }
+            type = frame.readUInt16BE(12);
+            offset = 14;
+            while (type === ETHERTYPE_VLAN && frame.length >= offset + 4) {
+                type = frame.readUInt16BE(offset + 2);
+                offset += 4;
+            }
+            break;
+        default:
+            throw new Error('unsupported pcap link type ' + linkType);
+    }
+    return type === ETHERTYPE_IPV4 || type === ETHERTYPE_IPV6 ? offset : -1;
+};
+
+// the UDP payload sent to port or null
+var udpPayload = function(packet, port) {
+    var version = packet[0] >> 4, offset, proto;
+    if (version === 4) {
+        var fragment = packet.readUInt16BE(6) & 0x3fff;
+        if (fragment) {
+            return null;
+        }
+        proto = packet[9];
+        offset = (packet[0] & 0xf) * 4;
+    } else if (version === 6) {
+        // extension headers are rare for DNS, skip those packets
+        proto = packet[6];
+        offset = 40;
+    } else {
+        return null;
+    }
+    if (proto !== PROTO_UDP || packet.length < offset + 8 ||
+        packet.readUInt16BE(offset + 2) !== port) {
+        return null;
+    }
+    return packet.slice(offset + 8);
+};
+
+// { name, type } of a DNS query or null for anything else
+var question = function(msg) {
+    if (msg.length < 12 || (msg[2] & 0x80) || msg.readUInt16BE(4) === 0) {
+        return null;
+    }
+    var labels = [], offset = 12;
+    while (offset < msg.length) {
+        var len = msg[offset];
+        if (len === 0) {
+            offset += 1;
+            break;
+        }
+        if (len > 63 || offset + 1 + len > msg.length) {
+            return null;
+        }
+        labels.push(msg.toString('ascii', offset + 1, offset + 1 + len));
+        offset += 1 + len;
+    }
+    if (offset + 4 > msg.length) {
+        return null;
+    }
+    return {
+        name : labels.length ? labels.join('.') : '.',
+        type : msg.readUInt16BE(offset)
+    };
+};
+
+var readPcap = function(data, port) {
+    if (data.length < 24) {
+        throw new Error('pcap file too short');
+    }
+    var magic = data.readUInt32LE(0), le = true;
+    if (magic !== PCAP_MAGIC && magic !== PCAP_MAGIC_NS) {
+        magic = data.readUInt32BE(0);
+        le = false;
+    }
+    if (magic !== PCAP_MAGIC && magic !== PCAP_MAGIC_NS) {
+        throw new Error('not a pcap file (pcapng is not supported)');
+    }
+    var u32 = function(offset) {
+        return le ? data.readUInt32LE(offset) : data.readUInt32BE(offset);
+    };
+    var fractionScale = magic === PCAP_MAGIC_NS ? 1e9 : 1e6;
+    var linkType = u32(20);
+    var queries = [];
+    var offset = 24;
+    while (offset + 16 <= data.length) {
+        var time = u32(offset) + u32(offset + 4) / fractionScale;
+        var captured = u32(offset + 8);
+        var frame = data.slice(offset + 16, offset + 16 + captured);
+        offset += 16 + captured;
+        var ip = ipOffset(linkType, frame);
+        if (ip < 0 || frame.length <= ip) {
+            continue;
+        }
+        var payload = udpPayload(frame.slice(ip), port);
+        var q = payload && question(payload);
+        if (q) {
+            q.time = time;
+            queries.push(q);
+        }
+    }
+    return queries;
+};
+
+var readLog = function(text, types) {
+    var queries = [];
+    text.split('\n').forEach(function(line, i) {
+        line = line.trim();
+        if (!line || line[0] === '#') {
+            return;
+        }
+        var fields = line.split(/\s+/);
+        if (fields.length < 3) {
+            throw new Error('line ' + (i + 1) + ': expected name type timestamp');
+        }
+        var type = /^\d+$/.test(fields[1]) ? Number(fields[1]) :
+                   types[fields[1].toUpperCase()];
+        if (type === undefined) {
+            throw new Error('line ' + (i + 1) + ': unknown type ' + fields[1]);
+        }
+        queries.push({ name : fields[0], type : type, time : Number(fields[2]) });
+    });
+    return queries;
+};
+
+// Read file as format (pcap, log or auto).  types maps mnemonics to
+// numbers for logs, port is the DNS port in captures.
+var load = function(file, format, types, port) {
+    var data = fs.readFileSync(file);
+    if (format === 'auto') {
+        var magic = data.length >= 4 ? data.readUInt32LE(0) : 0;
+        format = [ PCAP_MAGIC, PCAP_MAGIC_NS ].some(function(m) {
+            return magic === m || data.length >= 4 && data.readUInt32BE(0) === m;
+        }) ? 'pcap' : 'log';
+    }
+    var queries;
+    if (format === 'pcap') {
+        queries = readPcap(data, port || 53);
+    } else if (format === 'log') {
+        queries = readLog(data.toString('utf8'), types);
+    } else {
+        throw new Error('unknown format ' + format);
+    }
+    // captures from several interfaces may be out of order
+    queries.sort(function(a, b) {
+        return a.time - b.time;
+    });
+    var first = queries.length ? queries[0].time : 0;
+    queries.forEach(function(q) {
+        q.time -= first;
+    });
+    return queries;
+};
+
+module.exports = {
+    load : load,
+    question : question
+};
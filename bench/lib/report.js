@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Benchmark output.  Results are flat objects of numbers; printed as an
+// aligned table or, with --json, as one JSON line so runs can be compared
+// by scripts.
+
+var format = function(v) {
+    if (typeof v !== 'number') {
+        return String(v);
+    }
+    if (Math.floor(v) === v) {
+        return String(v);
+    }
+    return v.toFixed(v < 10 ? 3 : 1);
+};
+
+// result is { name, ...values }; values may be nested one level
+var print = function(result, json) {
+    if (json) {
+        console.log(JSON.stringify(result));
+        return;
+    }
+    var rows = [];
+    var walk = function(obj, prefix) {
+        Object.keys(obj).forEach(function(k) {
+            if (k === 'name' && !prefix) {
+                return;
+            }
+            var v = obj[k];
+            if (v !== null && typeof v === 'object' && !Array.isArray(v)) {
+                walk(v, prefix + k + '.');
+            } else {
+                rows.push([prefix + k, format(v)]);
+            }
+        });
+    };
+    walk(result, '');
+    var width = 0;
+    rows.forEach(function(r) {
+        width = Math.max(width, r[0].length);
+    });
+    console.log(result.name);
+    rows.forEach(function(r) {
+        var label = r[0];
+        while (label.length < width) {
+            label += ' ';
+        }
+        console.log('  ' + label + '  ' + r[1]);
+    });
+};
+
+module.exports = {
+    print : print
+};
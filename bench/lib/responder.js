@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// A minimal authoritative DNS responder for benchmarks.  Answers every
+// question over UDP and TCP on the loopback so lookups never leave the
+// machine:
+//   A     -> 127.0.0.1
+//   AAAA  -> ::1
+//   PTR   -> localhost.
+//   SRV   -> 0 0 <port> localhost.
+//   other -> NOERROR with no answers
+//
+// Run it in its own process (see fork) so that its CPU time is not
+// charged to the process being measured.
+//
+// Options: address, port, and delay - millis to hold each answer back,
+// with up to the same again of jitter, so queries stay in flight.
+
+var dgram = require('dgram'),
+    net = require('net'),
+    child_process = require('child_process');
+
+var TYPE_A = 1,
+    TYPE_PTR = 12,
+    TYPE_AAAA = 28,
+    TYPE_SRV = 33,
+    CLASS_IN = 1,
+    TTL = 300;
+
+// offset just past the first question or -1 if the message is malformed
+var questionEnd = function(msg) {
+    var offset = 12;
+    while (offset < msg.length) {
+        var len = msg[offset];
+        if (len === 0) {
+            offset += 1;
+            break;
+        }
+        if ((len & 0xc0) !== 0) {
+            // no compression in questions we send
+            return -1;
+        }
+        offset += len + 1;
+    }
+    offset += 4;
+    return offset <= msg.length ? offset : -1;
+};
+
+// encode a dotted name as uncompressed wire format
+var encodeName = function(name) {
+    var labels = name.split('.').filter(function(l) { return l.length > 0; });
+    var size = 1;
+    labels.forEach(function(l) { size += l.length + 1; });
+    var buf = new Buffer(size);
+    var offset = 0;
+    labels.forEach(function(l) {
+        buf[offset++] = l.length;
+        buf.write(l, offset, 'ascii');
+        offset += l.length;
+    });
+    buf[offset] = 0;
+    return buf;
+};
+
+var LOCALHOST = encodeName('localhost.');
+
+var rdataFor = function(qtype, port) {
+    var rdata;
+    switch (qtype) {
+        case TYPE_A:
+            return new Buffer([127, 0, 0, 1]);
+        case TYPE_AAAA:
+            rdata = new Buffer(16);
+            rdata.fill(0);
+            rdata[15] = 1;
+            return rdata;
+        case TYPE_PTR:
+            return LOCALHOST;
+        case TYPE_SRV:
+            rdata = new Buffer(6 + LOCALHOST.length);
+            rdata.writeUInt16BE(0, 0);
+            rdata.writeUInt16BE(0, 2);
+            rdata.writeUInt16BE(port, 4);
+            LOCALHOST.copy(rdata, 6);
+            return rdata;
+    }
+    return null;
+};
+
+// Build the answer to a query.  Returns null for messages to drop.
+var answer = function(query, port) {
+    if (query.length < 12 || (query[2] & 0x80) !== 0 ||
+        query.readUInt16BE(4) !== 1) {
+        return null;
+    }
+    var end = questionEnd(query);
+    if (end < 0) {
+        return null;
+    }
+    var qtype = query.readUInt16BE(end - 4);
+    var rdata = rdataFor(qtype, port);
+    var size = end + (rdata ? 12 + rdata.length : 0);
+    var msg = new Buffer(size);
+    query.copy(msg, 0, 0, end);
+    // QR, AA and the query's opcode and RD / RA, NOERROR
+    msg[2] = 0x84 | (query[2] & 0x79);
+    msg[3] = 0x80;
+    msg.writeUInt16BE(1, 4);
+    msg.writeUInt16BE(rdata ? 1 : 0, 6);
+    msg.writeUInt16BE(0, 8);
+    msg.writeUInt16BE(0, 10);
+    if (rdata) {
+        var offset = end;
+        // name is a pointer to the question
+        msg.writeUInt16BE(0xc00c, offset);
+        msg.writeUInt16BE(qtype, offset + 2);
+        msg.writeUInt16BE(CLASS_IN, offset + 4);
+        msg.writeUInt32BE(TTL, offset + 6);
+        msg.writeUInt16BE(rdata.length, offset + 10);
+        rdata.copy(msg, offset + 12);
+    }
+    return msg;
+};
+
+var writer = function(conn, data) {
+    return function() {
+        if (conn.writable) {
+            conn.write(data);
+        }
+    };
+};
+
+// Start answering on a free loopback port for both UDP and TCP.
+// callback(err, { port, close })
+var start = function(opts, callback) {
+    opts = opts || {};
+    var address = opts.address || '127.0.0.1';
+    var udp = dgram.createSocket(address.indexOf(':') >= 0 ? 'udp6' : 'udp4');
+    var tcp = null;
+    // the bound port, also the SRV target port in every answer
+    var port = 0;
+    var stats = { udp : 0, tcp : 0 };
+    var delay = opts.delay || 0;
+
+    var later = function(fn) {
+        if (delay > 0) {
+            setTimeout(fn, delay + Math.random() * delay);
+        } else {
+            fn();
+        }
+    };
+
+    udp.on('message', function(query, rinfo) {
+        var msg = answer(query, port);
+        if (msg) {
+            stats.udp++;
+            later(function() {
+                udp.send(msg, 0, msg.length, rinfo.port, rinfo.address);
+            });
+        }
+    });
+
+    udp.bind(opts.port || 0, address, function() {
+        port = udp.address().port;
+        tcp = net.createServer(function(conn) {
+            var pending = new Buffer(0);
+            conn.on('data', function(chunk) {
+                pending = Buffer.concat([pending, chunk]);
+                while (pending.length >= 2) {
+                    var len = pending.readUInt16BE(0);
+                    if (pending.length < len + 2) {
+                        break;
+                    }
+                    var msg = answer(pending.slice(2, len + 2), port);
+                    pending = pending.slice(len + 2);
+                    if (msg) {
+                        var framed = new Buffer(msg.length + 2);
+                        framed.writeUInt16BE(msg.length, 0);
+                        msg.copy(framed, 2);
+                        stats.tcp++;
+                        later(writer(conn, framed));
+                    }
+                }
+            });
+            conn.on('error', function() { });
+        });
+        tcp.on('error', callback);
+        tcp.listen(port, address, function() {
+            callback(null, {
+                port : port,
+                stats : stats,
+                close : function() {
+                    udp.close();
+                    tcp.close();
+                }
+            });
+        });
+    });
+};
+
+// Run the responder in a child process.  callback(err, { port, close })
+var fork = function(opts, callback) {
+    var child = child_process.fork(__filename, [JSON.stringify(opts || {})]);
+    var done = false;
+    child.on('message', function(m) {
+        if (done) {
+            return;
+        }
+        done = true;
+        if (m.error) {
+            child.kill();
+            return callback(new Error(m.error));
+        }
+        callback(null, {
+            port : m.port,
+            close : function() {
+                child.kill();
+            }
+        });
+    });
+    child.on('exit', function(code) {
+        if (!done) {
+            done = true;
+            callback(new Error('responder exited with ' + code));
+        }
+    });
+};
+
+module.exports = {
+    start : start,
+    fork : fork,
+    answer : answer
+};
+
+if (require.main === module) {
+    start(JSON.parse(process.argv[2] || '{}'), function(err, responder) {
+        if (!process.send) {
+            if (err) {
+                throw err;
+            }
+            console.log('listening on 127.0.0.1#' + responder.port);
+            return;
+        }
+        if (err) {
+            process.send({ error : err.message });
+        } else {
+            process.send({ port : responder.port });
+            // go away with the parent
+            process.on('disconnect', function() {
+                process.exit(0);
+            });
+        }
+    });
+}
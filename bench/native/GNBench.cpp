@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Native side of the benchmarks, built as getdns_bench.node when
+// node-gyp is run with -Dbuild_bench=true.  Times the native pieces of
+// the binding in isolation, without a network or an event loop.
+//
+// The module also exports the Context and constants of the binding,
+// built with the getdns query functions replaced by the stub in
+// GNStub.h, so the cost of the binding itself can be measured.
+
+#include <getdns/getdns.h>
+#include <getdns/getdns_extra.h>
+
+#include <nan.h>
+#include <node.h>
+#include <uv.h>
+
+#include <string.h>
+
+#include "GNUtil.h"
+#include "GNMemory.h"
+#include "GNContext.h"
+#include "GNLibuv.h"
+#include "GNStub.h"
+
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace v8;
+
+// GC time while a benchmark runs
+static uint64_t gcStart = 0;
+static uint64_t gcNanos = 0;
+static uint32_t gcCount = 0;
+
+static NAN_GC_CALLBACK(GCPrologue) {
+    gcStart = uv_hrtime();
+}
+
+static NAN_GC_CALLBACK(GCEpilogue) {
+    if (gcStart) {
+        gcNanos += uv_hrtime() - gcStart;
+        ++gcCount;
+        gcStart = 0;
+    }
+}
+
+static void startGCTiming() {
+    gcStart = 0;
+    gcNanos = 0;
+    gcCount = 0;
+    NanAddGCPrologueCallback(GCPrologue);
+    NanAddGCEpilogueCallback(GCEpilogue);
+}
+
+static void stopGCTiming() {
+    NanRemoveGCPrologueCallback(GCPrologue);
+    NanRemoveGCEpilogueCallback(GCEpilogue);
+}
+
+static void setNumber(Handle<Object> obj, const char* name, double value) {
+    obj->Set(NanNew<String>(name), NanNew<Number>(value));
+}
+
+// convert(responses, iterations)
+// Turns each response object into a getdns_dict once and then times
+// GNUtil::convertToJSObj over it.  The dicts are allocated through a
+// counting allocator so the getdns allocations made while converting
+// are counted too.  Returns one result per response:
+// { iterations, nanos, nodes, strings, buffers, binary_bytes,
+//   native_allocations, gc_nanos, gc_count }
+static NAN_METHOD(Convert) {
+    NanScope();
+    if (args.Length() < 2 || !args[0]->IsArray() || !args[1]->IsNumber()) {
+        NanThrowTypeError("convert(responses, iterations)");
+        NanReturnUndefined();
+    }
+    Handle<Array> responses = Handle<Array>::Cast(args[0]);
+    uint32_t iterations = args[1]->Uint32Value();
+
+    GNAllocator allocator;
+    getdns_context* context = NULL;
+    getdns_return_t r = getdns_context_create_with_extended_memory_functions(
+        &context, 0, &allocator,
+        GNAllocator::Malloc, GNAllocator::Realloc, GNAllocator::Free);
+    if (r != GETDNS_RETURN_GOOD) {
+        NanThrowError("Unable to create a getdns context.");
+        NanReturnUndefined();
+    }
+
+    Local<Array> results = NanNew<Array>(responses->Length());
+    for (uint32_t i = 0; i < responses->Length(); ++i) {
+        Local<Value> response = responses->Get(i);
+        if (!GNUtil::isDictionaryObject(response)) {
+            getdns_context_destroy(context);
+            NanThrowTypeError("responses must be objects");
+            NanReturnUndefined();
+        }
+        getdns_dict* dict = GNUtil::convertToDict(response->ToObject(),
+                                                  NULL, context);
+
+        GNConvertStats stats;
+        memset(&stats, 0, sizeof(stats));
+        uint64_t allocationsBefore = allocator.totalAllocations();
+        startGCTiming();
+        uint64_t start = uv_hrtime();
+        for (uint32_t n = 0; n < iterations; ++n) {
+            // let each converted response become garbage
+            NanScope();
+            GNUtil::convertToJSObj(dict, &stats);
+        }
+        uint64_t nanos = uv_hrtime() - start;
+        stopGCTiming();
+        uint64_t allocations = allocator.totalAllocations() - allocationsBefore;
+        getdns_dict_destroy(dict);
+
+        Local<Object> result = NanNew<Object>();
+        setNumber(result, "iterations", iterations);
+        setNumber(result, "nanos", (double) nanos);
+        setNumber(result, "nodes", (double) stats.nodes);
+        setNumber(result, "strings", (double) stats.strings);
+        setNumber(result, "buffers", (double) stats.buffers);
+        setNumber(result, "binary_bytes", (double) stats.binaryBytes);
+        setNumber(result, "native_allocations", (double) allocations);
+        setNumber(result, "gc_nanos", (double) gcNanos);
+        setNumber(result, "gc_count", gcCount);
+        results->Set(i, result);
+    }
+    getdns_context_destroy(context);
+    NanReturnValue(results);
+}
+
+// flush([callbackType]) - complete the lookups held by the getdns stub,
+// with GETDNS_CALLBACK_CANCEL unless told otherwise.  Returns the count.
+static NAN_METHOD(Flush) {
+    NanScope();
+    getdns_callback_type_t type = GETDNS_CALLBACK_CANCEL;
+    if (args.Length() > 0 && args[0]->IsNumber()) {
+        type = (getdns_callback_type_t) args[0]->Uint32Value();
+    }
+    NanReturnValue(NanNew<Number>((double) gn_stub_flush(type)));
+}
+
+static NAN_METHOD(Pending) {
+    NanScope();
+    NanReturnValue(NanNew<Number>((double) gn_stub_pending()));
+}
+
+// The event loop adapter driven directly on the default loop, with
+// socketpair fds standing in for upstream sockets
+static getdns_eventloop* adapterLoop = NULL;
+static std::vector<int> adapterFds;
+static std::vector<getdns_eventloop_event*> adapterEvents;
+// held events polling a socket, each on its own
+static size_t adapterPolled = 0;
+
+static void noopEventCallback(void* userarg) {
+}
+
+static bool openAdapter(size_t fds) {
+    if (!adapterLoop) {
+        adapterLoop = gn_libuv_create(uv_default_loop());
+        if (!adapterLoop) {
+            return false;
+        }
+    }
+    while (adapterFds.size() < fds) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_DGRAM, 0, pair) != 0) {
+            return false;
+        }
+        // only one end is polled, the other just keeps it open
+        adapterFds.push_back(pair[0]);
+        adapterFds.push_back(pair[1]);
+    }
+    return true;
+}
+
+// adapterSchedule(count, fds, timeoutMs, poll) - schedule count events,
+// each with a timeout.  When poll is true events also get a read
+// callback on a socket of their own, as a query has, until fds sockets
+// are in use; the rest are timeout only.  The events are held until
+// adapterClear.  Returns the nanos spent in the adapter.
+static NAN_METHOD(AdapterSchedule) {
+    NanScope();
+    uint32_t count = args[0]->Uint32Value();
+    uint32_t fds = args[1]->IsNumber() ? args[1]->Uint32Value() : 1;
+    uint32_t timeout = args[2]->IsNumber() ? args[2]->Uint32Value() : 5000;
+    bool poll = args.Length() < 4 || args[3]->IsTrue();
+    if (fds == 0 || !openAdapter(fds * 2)) {
+        NanThrowError("Unable to set up the event loop adapter.");
+        NanReturnUndefined();
+    }
+    std::vector<getdns_eventloop_event*> events(count);
+    std::vector<int> eventFds(count, -1);
+    for (uint32_t i = 0; i < count; ++i) {
+        events[i] = (getdns_eventloop_event*) calloc(1, sizeof(getdns_eventloop_event));
+        events[i]->timeout_cb = noopEventCallback;
+        // libuv allows a single poll handle per fd
+        if (poll && adapterPolled < fds) {
+            events[i]->read_cb = noopEventCallback;
+            eventFds[i] = adapterFds[adapterPolled * 2];
+            ++adapterPolled;
+        }
+    }
+    uint64_t start = uv_hrtime();
+    for (uint32_t i = 0; i < count; ++i) {
+        adapterLoop->vmt->schedule(adapterLoop, eventFds[i], timeout, events[i]);
+    }
+    uint64_t nanos = uv_hrtime() - start;
+    adapterEvents.insert(adapterEvents.end(), events.begin(), events.end());
+    NanReturnValue(NanNew<Number>((double) nanos));
+}
+
+// adapterClear() - clear every held event.  Returns the nanos spent in
+// the adapter.  The handles close on the next turn of the loop.
+static NAN_METHOD(AdapterClear) {
+    NanScope();
+    uint64_t start = uv_hrtime();
+    for (size_t i = 0; i < adapterEvents.size(); ++i) {
+        adapterLoop->vmt->clear(adapterLoop, adapterEvents[i]);
+    }
+    uint64_t nanos = uv_hrtime() - start;
+    for (size_t i = 0; i < adapterEvents.size(); ++i) {
+        free(adapterEvents[i]);
+    }
+    adapterEvents.clear();
+    adapterPolled = 0;
+    NanReturnValue(NanNew<Number>((double) nanos));
+}
+
+static void Init(Handle<Object> target) {
+    // Context and constants, built against the getdns stub
+    GNContext::Init(target);
+    target->Set(NanNew<String>("convert"),
+                NanNew<FunctionTemplate>(Convert)->GetFunction());
+    target->Set(NanNew<String>("flush"),
+                NanNew<FunctionTemplate>(Flush)->GetFunction());
+    target->Set(NanNew<String>("pending"),
+                NanNew<FunctionTemplate>(Pending)->GetFunction());
+    target->Set(NanNew<String>("adapterSchedule"),
+                NanNew<FunctionTemplate>(AdapterSchedule)->GetFunction());
+    target->Set(NanNew<String>("adapterClear"),
+                NanNew<FunctionTemplate>(AdapterClear)->GetFunction());
+}
+
+NODE_MODULE(getdns_bench, Init)
@@ -0,0 +1,600 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Fault injecting DNS responder for benchmarks and offline testing of
+// timeouts, retries and TCP fallback.  Built as gn_responder with
+// node-gyp rebuild -- -Dbuild_bench=true.
+//
+//   gn_responder -z zonefile [-f faultfile] [-a address] [-p port] [-s seed]
+//
+// Answers from the zone over UDP and TCP on one port and prints
+// "listening on <address>#<port>" once ready.  The fault file has a
+// rule per line, "*" being the default for names without one:
+//
+//   <name|*> [latency=ms] [jitter=ms] [loss=p] [tc=p] [servfail=p] [reset=p]
+//
+// latency and jitter hold answers back, loss drops queries, tc answers
+// over UDP with the TC bit and no records, servfail answers SERVFAIL
+// and reset closes TCP connections with a RST instead of answering.
+// p is a probability between 0 and 1.
+
+#include <ldns/ldns.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+typedef struct FaultRule {
+    // NULL for the default rule
+    ldns_rdf* name;
+    uint32_t latencyMs;
+    uint32_t jitterMs;
+    double loss;
+    double tc;
+    double servfail;
+    double reset;
+} FaultRule;
+
+// An answer held back until due
+typedef struct Pending {
+    // connection id for TCP, 0 for UDP
+    uint64_t conn;
+    struct sockaddr_storage addr;
+    socklen_t addrLen;
+    std::string wire;
+    bool reset;
+} Pending;
+
+typedef struct Connection {
+    uint64_t id;
+    std::string buffer;
+    // framed answers not written yet, sent once the socket is writable
+    std::string out;
+} Connection;
+
+static ldns_zone* zone = NULL;
+static std::vector<FaultRule> rules;
+static FaultRule defaultRule;
+
+static int udpFd = -1;
+static int tcpFd = -1;
+static std::map<int, Connection> connections;
+static uint64_t nextConnection = 1;
+static std::multimap<uint64_t, Pending> pending;
+
+// counters printed on exit
+static uint64_t queries = 0, dropped = 0, truncated = 0,
+                servfails = 0, resets = 0;
+
+static volatile sig_atomic_t stopping = 0;
+
+static void onSignal(int) {
+    stopping = 1;
+}
+
+static uint64_t nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool chance(double p) {
+    return p > 0 && (double) random() / RAND_MAX < p;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: gn_responder -z zonefile [-f faultfile] "
+                    "[-a address] [-p port] [-s seed]\n");
+    exit(2);
+}
+
+static bool parseRule(char* line, FaultRule* rule) {
+    memset(rule, 0, sizeof(FaultRule));
+    char* save = NULL;
+    char* tok = strtok_r(line, " \t\r\n", &save);
+    if (!tok || tok[0] == '#') {
+        return false;
+    }
+    if (strcmp(tok, "*") != 0) {
+        rule->name = ldns_dname_new_frm_str(tok);
+        if (!rule->name) {
+            fprintf(stderr, "bad name %s\n", tok);
+            exit(2);
+        }
+    }
+    while ((tok = strtok_r(NULL, " \t\r\n", &save))) {
+        char* eq = strchr(tok, '=');
+        if (!eq) {
+            fprintf(stderr, "bad fault %s\n", tok);
+            exit(2);
+        }
+        *eq = 0;
+        const char* value = eq + 1;
+        if (strcmp(tok, "latency") == 0) {
+            rule->latencyMs = (uint32_t) atoi(value);
+        } else if (strcmp(tok, "jitter") == 0) {
+            rule->jitterMs = (uint32_t) atoi(value);
+        } else if (strcmp(tok, "loss") == 0) {
+            rule->loss = atof(value);
+        } else if (strcmp(tok, "tc") == 0) {
+            rule->tc = atof(value);
+        } else if (strcmp(tok, "servfail") == 0) {
+            rule->servfail = atof(value);
+        } else if (strcmp(tok, "reset") == 0) {
+            rule->reset = atof(value);
+        } else {
+            fprintf(stderr, "unknown fault %s\n", tok);
+            exit(2);
+        }
+    }
+    return true;
+}
+
+static void loadFaults(const char* file) {
+    FILE* fp = fopen(file, "r");
+    if (!fp) {
+        perror(file);
+        exit(2);
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), fp)) {
+        FaultRule rule;
+        if (!parseRule(line, &rule)) {
+            continue;
+        }
+        if (rule.name) {
+            rules.push_back(rule);
+        } else {
+            defaultRule = rule;
+        }
+    }
+    fclose(fp);
+}
+
+static const FaultRule& findRule(const ldns_rdf* name) {
+    for (size_t i = 0; i < rules.size(); ++i) {
+        if (ldns_dname_compare(rules[i].name, name) == 0) {
+            return rules[i];
+        }
+    }
+    return defaultRule;
+}
+
+// Build the answer to query from the zone.  Truncates when the answer
+// does not fit over UDP or the rule says so.
+static bool buildAnswer(ldns_pkt* query, const FaultRule& rule, bool tcp,
+                        std::string* out) {
+    ldns_rr* question = ldns_rr_list_rr(ldns_pkt_question(query), 0);
+    const ldns_rdf* qname = ldns_rr_owner(question);
+    ldns_rr_type qtype = ldns_rr_get_type(question);
+
+    bool truncate = !tcp && chance(rule.tc);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        ldns_pkt* answer = ldns_pkt_new();
+        ldns_pkt_set_id(answer, ldns_pkt_id(query));
+        ldns_pkt_set_opcode(answer, ldns_pkt_get_opcode(query));
+        ldns_pkt_set_qr(answer, true);
+        ldns_pkt_set_aa(answer, true);
+        ldns_pkt_set_rd(answer, ldns_pkt_rd(query));
+        ldns_pkt_push_rr(answer, LDNS_SECTION_QUESTION, ldns_rr_clone(question));
+
+        if (chance(rule.servfail)) {
+            ++servfails;
+            ldns_pkt_set_rcode(answer, LDNS_RCODE_SERVFAIL);
+        } else if (truncate) {
+            ldns_pkt_set_tc(answer, true);
+        } else {
+            ldns_rr_list* rrs = ldns_zone_rrs(zone);
+            bool nameFound = false, answered = false;
+            for (size_t i = 0; i < ldns_rr_list_rr_count(rrs); ++i) {
+                ldns_rr* rr = ldns_rr_list_rr(rrs, i);
+                if (ldns_dname_compare(ldns_rr_owner(rr), qname) != 0) {
+                    continue;
+                }
+                nameFound = true;
+                ldns_rr_type type = ldns_rr_get_type(rr);
+                if (type == qtype || qtype == LDNS_RR_TYPE_ANY ||
+                    type == LDNS_RR_TYPE_CNAME) {
+                    ldns_pkt_push_rr(answer, LDNS_SECTION_ANSWER, ldns_rr_clone(rr));
+                    answered = true;
+                }
+            }
+            if (!answered && ldns_zone_soa(zone)) {
+                ldns_pkt_push_rr(answer, LDNS_SECTION_AUTHORITY,
+                                 ldns_rr_clone(ldns_zone_soa(zone)));
+            }
+            ldns_pkt_set_rcode(answer, nameFound ? LDNS_RCODE_NOERROR :
+                                                   LDNS_RCODE_NXDOMAIN);
+        }
+
+        uint8_t* wire = NULL;
+        size_t size = 0;
+        ldns_status s = ldns_pkt2wire(&wire, answer, &size);
+        ldns_pkt_free(answer);
+        if (s != LDNS_STATUS_OK) {
+            return false;
+        }
+        size_t limit = ldns_pkt_edns(query) ? ldns_pkt_edns_udp_size(query) : 512;
+        if (!tcp && !truncate && size > limit) {
+            // too big for UDP, answer again with just the TC bit
+            free(wire);
+            truncate = true;
+            continue;
+        }
+        if (truncate) {
+            ++truncated;
+        }
+        out->assign((const char*) wire, size);
+        free(wire);
+        return true;
+    }
+    return false;
+}
+
+// Decide what happens to a query.  Returns false to drop it.
+static bool handleQuery(const uint8_t* data, size_t len, bool tcp,
+                        Pending* result, uint64_t* due) {
+    ++queries;
+    ldns_pkt* query = NULL;
+    if (ldns_wire2pkt(&query, data, len) != LDNS_STATUS_OK) {
+        ++dropped;
+        return false;
+    }
+    if (ldns_rr_list_rr_count(ldns_pkt_question(query)) != 1) {
+        ldns_pkt_free(query);
+        ++dropped;
+        return false;
+    }
+    const FaultRule& rule = findRule(
+        ldns_rr_owner(ldns_rr_list_rr(ldns_pkt_question(query), 0)));
+    if (chance(rule.loss)) {
+        ldns_pkt_free(query);
+        ++dropped;
+        return false;
+    }
+    result->reset = tcp && chance(rule.reset);
+    bool built = result->reset || buildAnswer(query, rule, tcp, &result->wire);
+    ldns_pkt_free(query);
+    if (!built) {
+        ++dropped;
+        return false;
+    }
+    uint32_t delay = rule.latencyMs;
+    if (rule.jitterMs) {
+        delay += random() % (rule.jitterMs + 1);
+    }
+    *due = nowMs() + delay;
+    return true;
+}
+
+static void closeConnection(int fd, bool reset) {
+    if (reset) {
+        // RST instead of FIN
+        struct linger lin;
+        lin.l_onoff = 1;
+        lin.l_linger = 0;
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+        ++resets;
+    }
+    close(fd);
+    connections.erase(fd);
+}
+
+static void readUdp() {
+    uint8_t buf[65536];
+    for (;;) {
+        Pending p;
+        p.conn = 0;
+        p.addrLen = sizeof(p.addr);
+        ssize_t n = recvfrom(udpFd, buf, sizeof(buf), 0,
+                             (struct sockaddr*) &p.addr, &p.addrLen);
+        if (n < 0) {
+            return;
+        }
+        uint64_t due;
+        if (handleQuery(buf, (size_t) n, false, &p, &due)) {
+            pending.insert(std::make_pair(due, p));
+        }
+    }
+}
+
+static void acceptTcp() {
+    for (;;) {
+        int fd = accept(tcpFd, NULL, NULL);
+        if (fd < 0) {
+            return;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        Connection conn;
+        conn.id = nextConnection++;
+        connections[fd] = conn;
+    }
+}
+
+static void readTcp(int fd) {
+    uint8_t buf[65536];
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0) {
+        if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+            closeConnection(fd, false);
+        }
+        return;
+    }
+    Connection& conn = connections[fd];
+    conn.buffer.append((const char*) buf, (size_t) n);
+    while (conn.buffer.size() >= 2) {
+        size_t len = ((uint8_t) conn.buffer[0] << 8) | (uint8_t) conn.buffer[1];
+        if (conn.buffer.size() < len + 2) {
+            break;
+        }
+        Pending p;
+        p.conn = conn.id;
+        p.addrLen = 0;
+        uint64_t due;
+        if (handleQuery((const uint8_t*) conn.buffer.data() + 2, len, true, &p, &due)) {
+            pending.insert(std::make_pair(due, p));
+        }
+        conn.buffer.erase(0, len + 2);
+    }
+}
+
+// Write what is queued for a connection.  Returns false once it is
+// closed.
+static bool flushConnection(int fd) {
+    Connection& conn = connections[fd];
+    while (!conn.out.empty()) {
+        ssize_t n = write(fd, conn.out.data(), conn.out.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                return true;
+            }
+            closeConnection(fd, false);
+            return false;
+        }
+        conn.out.erase(0, (size_t) n);
+    }
+    return true;
+}
+
+static int findConnection(uint64_t id) {
+    for (std::map<int, Connection>::iterator it = connections.begin();
+         it != connections.end(); ++it) {
+        if (it->second.id == id) {
+            return it->first;
+        }
+    }
+    return -1;
+}
+
+// Send the answers that are due.  Returns the millis until the next.
+static int sendDue() {
+    uint64_t now = nowMs();
+    while (!pending.empty() && pending.begin()->first <= now) {
+        Pending& p = pending.begin()->second;
+        if (p.conn == 0) {
+            sendto(udpFd, p.wire.data(), p.wire.size(), 0,
+                   (struct sockaddr*) &p.addr, p.addrLen);
+        } else {
+            int fd = findConnection(p.conn);
+            if (fd >= 0 && p.reset) {
+                closeConnection(fd, true);
+            } else if (fd >= 0) {
+                uint8_t prefix[2] = { (uint8_t) (p.wire.size() >> 8),
+                                      (uint8_t) p.wire.size() };
+                // queued behind anything not written yet so a short
+                // write never splits a message
+                std::string& out = connections[fd].out;
+                out.append((const char*) prefix, 2);
+                out += p.wire;
+                flushConnection(fd);
+            }
+        }
+        pending.erase(pending.begin());
+    }
+    if (pending.empty()) {
+        return -1;
+    }
+    return (int) (pending.begin()->first - now);
+}
+
+static int bindSocket(int type, const char* address, uint16_t port) {
+    struct sockaddr_storage addr;
+    memset(&addr, 0, sizeof(addr));
+    socklen_t len;
+    int family;
+    struct sockaddr_in* in4 = (struct sockaddr_in*) &addr;
+    struct sockaddr_in6* in6 = (struct sockaddr_in6*) &addr;
+    if (inet_pton(AF_INET, address, &in4->sin_addr) == 1) {
+        family = in4->sin_family = AF_INET;
+        in4->sin_port = htons(port);
+        len = sizeof(*in4);
+    } else if (inet_pton(AF_INET6, address, &in6->sin6_addr) == 1) {
+        family = in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(port);
+        len = sizeof(*in6);
+    } else {
+        fprintf(stderr, "bad address %s\n", address);
+        exit(2);
+    }
+    int fd = socket(family, type, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(fd, (struct sockaddr*) &addr, len) != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+static uint16_t boundPort(int fd) {
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (struct sockaddr*) &addr, &len);
+    if (addr.ss_family == AF_INET) {
+        return ntohs(((struct sockaddr_in*) &addr)->sin_port);
+    }
+    return ntohs(((struct sockaddr_in6*) &addr)->sin6_port);
+}
+
+int main(int argc, char** argv) {
+    const char* zoneFile = NULL;
+    const char* faultFile = NULL;
+    const char* address = "127.0.0.1";
+    uint16_t port = 0;
+    unsigned int seed = (unsigned int) time(NULL);
+    int opt;
+    while ((opt = getopt(argc, argv, "z:f:a:p:s:")) != -1) {
+        switch (opt) {
+            case 'z': zoneFile = optarg; break;
+            case 'f': faultFile = optarg; break;
+            case 'a': address = optarg; break;
+            case 'p': port = (uint16_t) atoi(optarg); break;
+            case 's': seed = (unsigned int) atoi(optarg); break;
+            default: usage();
+        }
+    }
+    if (!zoneFile) {
+        usage();
+    }
+    srandom(seed);
+    memset(&defaultRule, 0, sizeof(defaultRule));
+
+    FILE* fp = fopen(zoneFile, "r");
+    if (!fp) {
+        perror(zoneFile);
+        return 2;
+    }
+    ldns_status s = ldns_zone_new_frm_fp(&zone, fp, NULL, 3600, LDNS_RR_CLASS_IN);
+    fclose(fp);
+    if (s != LDNS_STATUS_OK) {
+        fprintf(stderr, "%s: %s\n", zoneFile, ldns_get_errorstr_by_id(s));
+        return 2;
+    }
+    if (faultFile) {
+        loadFaults(faultFile);
+    }
+
+    // UDP and TCP on the same port, retrying while a free UDP port is
+    // taken for TCP
+    for (int attempt = 0; attempt < 10 && tcpFd < 0; ++attempt) {
+        udpFd = bindSocket(SOCK_DGRAM, address, port);
+        if (udpFd < 0) {
+            perror("bind");
+            return 1;
+        }
+        tcpFd = bindSocket(SOCK_STREAM, address, boundPort(udpFd));
+        if (tcpFd < 0 || listen(tcpFd, 128) != 0) {
+            if (port) {
+                perror("listen");
+                return 1;
+            }
+            close(udpFd);
+            if (tcpFd >= 0) {
+                close(tcpFd);
+                tcpFd = -1;
+            }
+        }
+    }
+    if (tcpFd < 0) {
+        fprintf(stderr, "no free port\n");
+        return 1;
+    }
+    printf("listening on %s#%u\n", address, boundPort(udpFd));
+    fflush(stdout);
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    std::vector<struct pollfd> fds;
+    while (!stopping) {
+        int timeout = sendDue();
+        fds.clear();
+        struct pollfd pfd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        pfd.fd = udpFd;
+        fds.push_back(pfd);
+        pfd.fd = tcpFd;
+        fds.push_back(pfd);
+        for (std::map<int, Connection>::iterator it = connections.begin();
+             it != connections.end(); ++it) {
+            pfd.fd = it->first;
+            pfd.events = it->second.out.empty() ? POLLIN : POLLIN | POLLOUT;
+            fds.push_back(pfd);
+        }
+        if (poll(&fds[0], fds.size(), timeout) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            return 1;
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (!fds[i].revents) {
+                continue;
+            }
+            if (fds[i].fd == udpFd) {
+                readUdp();
+            } else if (fds[i].fd == tcpFd) {
+                acceptTcp();
+            } else if (connections.count(fds[i].fd)) {
+                if ((fds[i].revents & POLLOUT) && !flushConnection(fds[i].fd)) {
+                    continue;
+                }
+                if (fds[i].revents & ~POLLOUT) {
+                    readTcp(fds[i].fd);
+                }
+            }
+        }
+    }
+    fprintf(stderr, "queries %llu dropped %llu truncated %llu servfail %llu reset %llu\n",
+            (unsigned long long) queries, (unsigned long long) dropped,
+            (unsigned long long) truncated, (unsigned long long) servfails,
+            (unsigned long long) resets);
+    ldns_zone_deep_free(zone);
+    return 0;
+}
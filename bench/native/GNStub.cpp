@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GNStub.h"
+
+#include <map>
+
+typedef struct StubQuery {
+    getdns_context* context;
+    void* userarg;
+    getdns_callback_t callbackfn;
+} StubQuery;
+
+// held queries by transaction id, which also keeps them in order
+static std::map<getdns_transaction_t, StubQuery> pending;
+static getdns_transaction_t nextTransId = 1;
+
+static getdns_return_t hold(getdns_context* context, void* userarg,
+                            getdns_transaction_t* transaction_id,
+                            getdns_callback_t callbackfn) {
+    if (!context || !callbackfn) {
+        return GETDNS_RETURN_INVALID_PARAMETER;
+    }
+    StubQuery query;
+    query.context = context;
+    query.userarg = userarg;
+    query.callbackfn = callbackfn;
+    getdns_transaction_t transId = nextTransId++;
+    pending[transId] = query;
+    if (transaction_id) {
+        *transaction_id = transId;
+    }
+    return GETDNS_RETURN_GOOD;
+}
+
+getdns_return_t gn_stub_general(getdns_context* context, const char* name,
+    uint16_t request_type, getdns_dict* extensions, void* userarg,
+    getdns_transaction_t* transaction_id, getdns_callback_t callbackfn) {
+    return hold(context, userarg, transaction_id, callbackfn);
+}
+
+getdns_return_t gn_stub_address(getdns_context* context, const char* name,
+    getdns_dict* extensions, void* userarg,
+    getdns_transaction_t* transaction_id, getdns_callback_t callbackfn) {
+    return hold(context, userarg, transaction_id, callbackfn);
+}
+
+getdns_return_t gn_stub_hostname(getdns_context* context, getdns_dict* address,
+    getdns_dict* extensions, void* userarg,
+    getdns_transaction_t* transaction_id, getdns_callback_t callbackfn) {
+    return hold(context, userarg, transaction_id, callbackfn);
+}
+
+getdns_return_t gn_stub_service(getdns_context* context, const char* name,
+    getdns_dict* extensions, void* userarg,
+    getdns_transaction_t* transaction_id, getdns_callback_t callbackfn) {
+    return hold(context, userarg, transaction_id, callbackfn);
+}
+
+getdns_return_t gn_stub_cancel_callback(getdns_context* context,
+    getdns_transaction_t transaction_id) {
+    std::map<getdns_transaction_t, StubQuery>::iterator it =
+        pending.find(transaction_id);
+    if (it == pending.end()) {
+        return GETDNS_RETURN_UNKNOWN_TRANSACTION;
+    }
+    StubQuery query = it->second;
+    pending.erase(it);
+    query.callbackfn(query.context, GETDNS_CALLBACK_CANCEL, NULL,
+                     query.userarg, transaction_id);
+    return GETDNS_RETURN_GOOD;
+}
+
+size_t gn_stub_flush(getdns_callback_type_t callbackType) {
+    size_t completed = 0;
+    // callbacks may issue or cancel queries, so take one at a time
+    while (!pending.empty()) {
+        std::map<getdns_transaction_t, StubQuery>::iterator it = pending.begin();
+        getdns_transaction_t transId = it->first;
+        StubQuery query = it->second;
+        pending.erase(it);
+        query.callbackfn(query.context, callbackType, NULL,
+                         query.userarg, transId);
+        ++completed;
+    }
+    return completed;
+}
+
+size_t gn_stub_pending() {
+    return pending.size();
+}
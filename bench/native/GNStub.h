@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_STUB_H_
+#define _GN_STUB_H_
+
+// Stand ins for the getdns query functions, so the benchmarks can
+// measure the binding alone.  GNContext.cpp includes this when built
+// with GN_STUB_GETDNS.  Queries are never sent: they are held until
+// gn_stub_flush completes them.  Everything else in getdns is real.
+
+#include <getdns/getdns.h>
+
+#include <stddef.h>
+
+getdns_return_t gn_stub_general(getdns_context* context, const char* name,
+    uint16_t request_type, getdns_dict* extensions, void* userarg,
+    getdns_transaction_t* transaction_id, getdns_callback_t callbackfn);
+getdns_return_t gn_stub_address(getdns_context* context, const char* name,
+    getdns_dict* extensions, void* userarg,
+    getdns_transaction_t* transaction_id, getdns_callback_t callbackfn);
+getdns_return_t gn_stub_hostname(getdns_context* context, getdns_dict* address,
+    getdns_dict* extensions, void* userarg,
+    getdns_transaction_t* transaction_id, getdns_callback_t callbackfn);
+getdns_return_t gn_stub_service(getdns_context* context, const char* name,
+    getdns_dict* extensions, void* userarg,
+    getdns_transaction_t* transaction_id, getdns_callback_t callbackfn);
+// Like getdns, calls back with GETDNS_CALLBACK_CANCEL before returning
+getdns_return_t gn_stub_cancel_callback(getdns_context* context,
+    getdns_transaction_t transaction_id);
+
+// Complete every held query with callbackType and no response, in the
+// order they were made.  Returns the number completed.
+size_t gn_stub_flush(getdns_callback_type_t callbackType);
+size_t gn_stub_pending();
+
+#define getdns_general gn_stub_general
+#define getdns_address gn_stub_address
+#define getdns_hostname gn_stub_hostname
+#define getdns_service gn_stub_service
+#define getdns_cancel_callback gn_stub_cancel_callback
+
+#endif
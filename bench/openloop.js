@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Open loop load against a local responder.  Lookups are issued at a
+// fixed arrival rate whatever the latency, and latency is measured from
+// the time each lookup was meant to be sent, not from when the loop got
+// round to sending it.  A stalled loop then shows up as latency instead
+// of silently lowering the offered load (coordinated omission).
+//
+//   node bench/openloop.js [--rates=1000,5000,10000,20000] [--duration=10]
+//       [--method=lookup|getAddress] [--out=dir] [--json]
+//
+// Each rate in the sweep runs on a fresh context.  With --out the full
+// latency distribution of every rate is written there as an HDR
+// percentile file (openloop-<rate>.hdr) for plotting.
+
+var fs = require('fs'),
+    path = require('path'),
+    common = require('./lib/common'),
+    responder = require('./lib/responder'),
+    cpu = require('./lib/cpu'),
+    report = require('./lib/report'),
+    Histogram = require('./lib/histogram');
+
+var getdns = common.getdns;
+
+var opts = common.parseArgs({
+    rates : '1000,5000,10000,20000',
+    duration : 10,
+    method : 'lookup',
+    out : '',
+    json : false
+});
+
+var rates = opts.rates.split(',').map(Number).filter(function(r) {
+    return r > 0;
+});
+
+var runRate = function(port, rate, done) {
+    var ctx = common.stubContext(port);
+    var latency = new Histogram();
+    var total = Math.floor(rate * opts.duration);
+    var sent = 0, completed = 0, errors = 0;
+    var maxLag = 0;
+    var start = process.hrtime();
+    var startCpu = cpu.usage();
+
+    var finish = function() {
+        var elapsed = common.elapsedMicros(start) / 1e6;
+        var used = cpu.since(startCpu);
+        ctx.destroy();
+        done({
+            name : 'openloop ' + rate + '/s',
+            offered_qps : rate,
+            achieved_qps : completed / elapsed,
+            queries : completed,
+            errors : errors,
+            max_send_lag_ms : maxLag / 1000,
+            cpu_us_per_query : completed ? (used.user + used.system) / completed : 0,
+            latency_ms : latency.summary(1000)
+        }, latency);
+    };
+
+    var issue = function(intended) {
+        var callback = function(err, result) {
+            completed++;
+            if (err) {
+                errors++;
+            }
+            latency.record(common.elapsedMicros(start) - intended);
+            if (completed === total) {
+                finish();
+            }
+        };
+        var name = common.queryName(sent++);
+        if (opts.method === 'lookup') {
+            ctx.lookup(name, getdns.RRTYPE_A, callback);
+        } else {
+            ctx.getAddress(name, callback);
+        }
+    };
+
+    // send everything that is due, then come back on the next tick of
+    // the timer.  The timer's resolution only adds to the measured
+    // latency, it never hides it.
+    var tick = function() {
+        var now = common.elapsedMicros(start);
+        var due = Math.min(total, Math.floor(now * rate / 1e6) + 1);
+        while (sent < due) {
+            var intended = sent * 1e6 / rate;
+            maxLag = Math.max(maxLag, now - intended);
+            issue(intended);
+        }
+        if (sent < total) {
+            setTimeout(tick, 1);
+        }
+    };
+    tick();
+};
+
+var sweep = function(port, callback) {
+    var results = [];
+    var next = function(i) {
+        if (i === rates.length) {
+            return callback(results);
+        }
+        runRate(port, rates[i], function(result, latency) {
+            report.print(result, opts.json);
+            if (opts.out) {
+                fs.writeFileSync(path.join(opts.out, 'openloop-' + rates[i] + '.hdr'),
+                                 latency.toHdrText(1000));
+            }
+            results.push(result);
+            // let the destroyed context go before the next rate
+            setTimeout(function() {
+                next(i + 1);
+            }, 100);
+        });
+    };
+    next(0);
+};
+
+responder.fork({}, function(err, server) {
+    if (err) {
+        throw err;
+    }
+    sweep(server.port, function(results) {
+        server.close();
+        // the highest offered rate still achieved within 5%
+        var saturation = 0;
+        results.forEach(function(r) {
+            if (r.achieved_qps >= r.offered_qps * 0.95) {
+                saturation = Math.max(saturation, r.offered_qps);
+            }
+        });
+        if (!opts.json) {
+            console.log('highest rate sustained: ' + saturation + '/s');
+        }
+    });
+});
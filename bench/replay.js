@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Replays a real query mix.  Reads queries from a pcap or a
+// "name type timestamp" log (see bench/lib/querylog.js) and issues them
+// through one context at their original spacing, or scaled by --speed,
+// then reports throughput, CPU and the latency distribution.
+//
+//   node bench/replay.js --file=queries.pcap [--format=auto|pcap|log]
+//       [--speed=1] [--limit=0] [--dns-port=53] [--upstream=ip[#port]]
+//       [--answers=recording] [--timeout=2000] [--out=file] [--json]
+//
+// Answers come from the local responder unless --upstream names a real
+// one or --answers a recording made with context.record, which is then
+// replayed with its recorded latency.  Like bench/openloop.js, latency is
+// measured from when each query was due, so a loop that falls behind
+// shows up as latency.  --speed=0 sends as fast as possible.  --out
+// writes the latency distribution as an HDR percentile file.
+
+var fs = require('fs'),
+    common = require('./lib/common'),
+    responder = require('./lib/responder'),
+    querylog = require('./lib/querylog'),
+    cpu = require('./lib/cpu'),
+    report = require('./lib/report'),
+    Histogram = require('./lib/histogram');
+
+var getdns = common.getdns;
+
+var opts = common.parseArgs({
+    file : '',
+    format : 'auto',
+    speed : 1,
+    limit : 0,
+    dns_port : 53,
+    upstream : '',
+    answers : '',
+    timeout : 2000,
+    out : '',
+    json : false
+});
+
+if (!opts.file) {
+    throw new Error('--file is required');
+}
+
+// RRTYPE_* constants by mnemonic
+var types = {};
+Object.keys(getdns).forEach(function(k) {
+    if (k.indexOf('RRTYPE_') === 0) {
+        types[k.substring(7)] = getdns[k];
+    }
+});
+
+var queries = querylog.load(opts.file, opts.format, types, opts.dns_port);
+if (opts.limit > 0) {
+    queries = queries.slice(0, opts.limit);
+}
+if (!queries.length) {
+    throw new Error('no queries in ' + opts.file);
+}
+
+// when each query is due in micros from the start
+var dueAt = function(i) {
+    return opts.speed > 0 ? queries[i].time * 1e6 / opts.speed : 0;
+};
+
+var run = function(ctxOpts, done) {
+    ctxOpts.timeout = opts.timeout;
+    var ctx = getdns.createContext(ctxOpts);
+    var latency = new Histogram();
+    var sent = 0, completed = 0, errors = 0, maxLag = 0, inFlight = 0, maxInFlight = 0;
+    var distinct = {};
+    var start = process.hrtime();
+    var startCpu = cpu.usage();
+
+    var finish = function() {
+        var elapsed = common.elapsedMicros(start) / 1e6;
+        var used = cpu.since(startCpu);
+        var stats = ctx.stats();
+        ctx.destroy();
+        var span = queries[queries.length - 1].time;
+        var result = {
+            name : 'replay',
+            queries : completed,
+            distinct_names : Object.keys(distinct).length,
+            errors : errors,
+            capture_s : span,
+            elapsed_s : elapsed,
+            offered_qps : opts.speed > 0 && span > 0 ? completed * opts.speed / span : 0,
+            achieved_qps : completed / elapsed,
+            max_in_flight : maxInFlight,
+            max_send_lag_ms : maxLag / 1000,
+            cpu_us_per_query : (used.user + used.system) / completed,
+            latency_ms : latency.summary(1000)
+        };
+        if (stats.replay) {
+            result.answers_missed = stats.replay.misses;
+        }
+        done(result, latency);
+    };
+
+    var issue = function(q, due) {
+        inFlight++;
+        maxInFlight = Math.max(maxInFlight, inFlight);
+        distinct[q.name] = true;
+        ctx.lookup(q.name, q.type, function(err, result) {
+            inFlight--;
+            completed++;
+            if (err) {
+                errors++;
+            }
+            latency.record(common.elapsedMicros(start) - due);
+            if (completed === queries.length) {
+                finish();
+            }
+        });
+    };
+
+    // send everything that is due, then come back on the next timer tick
+    var tick = function() {
+        var now = common.elapsedMicros(start);
+        while (sent < queries.length && dueAt(sent) <= now) {
+            var due = dueAt(sent);
+            maxLag = Math.max(maxLag, now - due);
+            issue(queries[sent++], due);
+        }
+        if (sent < queries.length) {
+            var wait = (dueAt(sent) - common.elapsedMicros(start)) / 1000;
+            setTimeout(tick, Math.max(1, Math.min(wait, 1000)));
+        }
+    };
+    tick();
+};
+
+var done = function(result, latency) {
+    if (opts.out) {
+        fs.writeFileSync(opts.out, latency.toHdrText(1000));
+    }
+    report.print(result, opts.json);
+};
+
+if (opts.answers) {
+    run({ replay : opts.answers }, done);
+} else if (opts.upstream) {
+    var parts = opts.upstream.split('#');
+    var upstream = parts.length > 1 ? [ parts[0], Number(parts[1]) ] : parts[0];
+    run({ stub : true, upstreams : [ upstream ] }, done);
+} else {
+    responder.fork({}, function(err, server) {
+        if (err) {
+            throw err;
+        }
+        run({ stub : true, upstreams : [ [ '127.0.0.1', server.port ] ] }, function(result, latency) {
+            server.close();
+            done(result, latency);
+        });
+    });
+}
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Performance regression runner.  Runs the benchmark suites, writes
+// their results with a description of the machine to a JSON file and
+// compares them with the committed baseline.  Exits non zero when a
+// metric is worse than the baseline by more than its tolerance.
+//
+//   node bench/run.js [--suites=throughput,convert] [--out=file]
+//       [--baseline=bench/baseline.json] [--tolerance=0.1]
+//       [--update-baseline]
+//
+// --tolerance is the allowed relative change for metrics that have none
+// of their own.  A metric's tolerance is the first of: its own in the
+// baseline, the suite's, --tolerance when given, the baseline's and
+// the --tolerance default.  Suites needing the native benchmark module
+// are skipped when it is not built.  Baselines only mean something on
+// the machine they were taken on, so a baseline from another machine
+// gives a warning.  Refresh it with --update-baseline after an
+// intended change.
+
+var fs = require('fs'),
+    os = require('os'),
+    path = require('path'),
+    child_process = require('child_process'),
+    common = require('./lib/common');
+
+var opts = common.parseArgs({
+    suites : '',
+    out : '',
+    baseline : path.join(__dirname, 'baseline.json'),
+    tolerance : 0.1,
+    update_baseline : false
+});
+
+// an explicit --tolerance overrides the baseline's
+var explicitTolerance = process.argv.slice(2).some(function(arg) {
+    return /^--tolerance(=|$)/.test(arg);
+});
+
+// Suites, the arguments they run with here and the metrics compared.
+// Each metric is [result name, dotted path in the result, better] with
+// an optional tolerance for noisy metrics such as tail latencies.
+var SUITES = [
+    {
+        name : 'throughput',
+        script : 'throughput.js',
+        args : [ '--duration=5', '--concurrency=100' ],
+        metrics : [
+            [ 'throughput', 'qps', 'higher' ],
+            [ 'throughput', 'cpu_us_per_query', 'lower' ],
+            [ 'throughput', 'latency_ms.p99', 'lower', 0.25 ]
+        ]
+    },
+    {
+        name : 'openloop',
+        script : 'openloop.js',
+        args : [ '--rates=5000', '--duration=5' ],
+        metrics : [
+            [ 'openloop 5000/s', 'latency_ms.p99', 'lower', 0.25 ],
+            [ 'openloop 5000/s', 'latency_ms.p999', 'lower', 0.25 ]
+        ]
+    },
+    {
+        name : 'cancel',
+        script : 'cancel.js',
+        args : [ '--queries=20000' ],
+        metrics : [
+            [ 'cancel storm', 'cancel_ns.p50', 'lower' ],
+            [ 'cancel storm', 'leftover_queries', 'lower' ],
+            [ 'cancel storm', 'leftover_events', 'lower' ]
+        ]
+    },
+    {
+        name : 'churn',
+        script : 'churn.js',
+        args : [ '--contexts=5000' ],
+        metrics : [
+            [ 'churn native', 'create_us', 'lower' ],
+            [ 'churn createContext', 'create_destroy_us', 'lower' ]
+        ]
+    },
+    {
+        name : 'startup',
+        script : 'startup.js',
+        args : [ '--runs=20' ],
+        metrics : [
+            [ 'startup', 'require_ms.p50', 'lower', 0.25 ],
+            [ 'startup', 'context_ms.p50', 'lower', 0.25 ]
+        ]
+    },
+    {
+        name : 'convert',
+        script : 'convert.js',
+        native : true,
+        args : [ '--iterations=20000' ],
+        metrics : [
+            [ 'convert a', 'ns_per_response', 'lower' ],
+            [ 'convert txt_heavy', 'ns_per_response', 'lower' ],
+            [ 'convert dnssec_chain', 'ns_per_response', 'lower' ],
+            [ 'convert srv_large', 'ns_per_response', 'lower' ],
+            [ 'convert srv_large', 'native_allocations_per_response', 'lower' ]
+        ]
+    },
+    {
+        name : 'entry',
+        script : 'entry.js',
+        native : true,
+        args : [ '--calls=100000' ],
+        metrics : [
+            [ 'entry lookup', 'call_ns', 'lower' ],
+            [ 'entry lookup_ext', 'call_ns', 'lower' ],
+            [ 'entry getAddress', 'call_ns', 'lower' ]
+        ]
+    },
+    {
+        name : 'adapter',
+        script : 'adapter.js',
+        native : true,
+        args : [ '--pairs=100000' ],
+        metrics : [
+            [ 'adapter immediate', 'pair_ns', 'lower' ],
+            [ 'adapter immediate', 'leaked_events', 'lower' ]
+        ]
+    }
+];
+
+var nativeBuilt = function() {
+    try {
+        require('bindings')('getdns_bench');
+        return true;
+    } catch (e) {
+        return false;
+    }
+};
+
+var machine = function() {
+    var cpus = os.cpus();
+    var commit = '';
+    try {
+        commit = child_process.execSync('git rev-parse HEAD', {
+            cwd : __dirname, stdio : [ 'ignore', 'pipe', 'ignore' ]
+        }).toString().trim();
+    } catch (e) {
+        // not a checkout or no execSync on this node
+    }
+    return {
+        hostname : os.hostname(),
+        platform : os.platform(),
+        release : os.release(),
+        arch : os.arch(),
+        cpu : cpus.length ? cpus[0].model : '',
+        cpus : cpus.length,
+        memory : os.totalmem(),
+        node : process.version,
+        commit : commit
+    };
+};
+
+var lookupPath = function(obj, dotted) {
+    return dotted.split('.').reduce(function(o, k) {
+        return o === undefined || o === null ? undefined : o[k];
+    }, obj);
+};
+
+// run a suite and collect its JSON result lines by name
+var runSuite = function(suite, callback) {
+    var child = child_process.spawn(process.execPath,
+        [ path.join(__dirname, suite.script), '--json' ].concat(suite.args),
+        { stdio : [ 'ignore', 'pipe', 'inherit' ] });
+    var out = '';
+    child.stdout.on('data', function(chunk) {
+        out += chunk;
+    });
+    child.on('close', function(code) {
+        var results = {};
+        out.split('\n').forEach(function(line) {
+            if (line.charAt(0) !== '{') {
+                return;
+            }
+            var r = JSON.parse(line);
+            if (r.name) {
+                results[r.name] = r;
+            }
+        });
+        callback(code === 0 ? null : new Error(suite.name + ' exited with ' + code),
+                 results);
+    });
+};
+
+var selected = SUITES.filter(function(suite) {
+    return !opts.suites || opts.suites.split(',').indexOf(suite.name) >= 0;
+});
+var haveNative = nativeBuilt();
+
+var collect = function(callback) {
+    var metrics = {};
+    var failed = [];
+    var next = function(i) {
+        if (i === selected.length) {
+            return callback(metrics, failed);
+        }
+        var suite = selected[i];
+        if (suite.native && !haveNative) {
+            console.log('skipping ' + suite.name + ', getdns_bench is not built');
+            return next(i + 1);
+        }
+        console.log('running ' + suite.name);
+        runSuite(suite, function(err, results) {
+            if (err) {
+                failed.push(err.message);
+            }
+            suite.metrics.forEach(function(m) {
+                var value = lookupPath(results[m[0]], m[1]);
+                if (typeof value === 'number') {
+                    metrics[m[0] + ' ' + m[1]] = { value : value, better : m[2] };
+                    if (m[3] !== undefined) {
+                        metrics[m[0] + ' ' + m[1]].tolerance = m[3];
+                    }
+                }
+            });
+            next(i + 1);
+        });
+    };
+    next(0);
+};
+
+// Compare with the baseline.  Returns the regressions.
+var compare = function(metrics, baseline) {
+    var regressions = [];
+    Object.keys(metrics).forEach(function(key) {
+        var current = metrics[key];
+        var base = baseline.metrics[key];
+        if (!base) {
+            console.log('  ' + key + ' ' + current.value.toFixed(3) + ' (no baseline)');
+            return;
+        }
+        // the metric's own tolerance, then the suite's, then the global one
+        var tolerance = [ base.tolerance, current.tolerance,
+                          explicitTolerance ? opts.tolerance : undefined,
+                          baseline.tolerance, opts.tolerance ].filter(function(t) {
+            return t !== undefined;
+        })[0];
+        var change = base.value ? (current.value - base.value) / base.value :
+            (current.value === 0 ? 0 : Infinity);
+        var worse = current.better === 'higher' ? -change : change;
+        var status = worse > tolerance ? 'REGRESSION' : 'ok';
+        console.log('  ' + key + ' ' + current.value.toFixed(3) + ' vs ' +
+                    base.value.toFixed(3) + ' (' + (change * 100).toFixed(1) +
+                    '%) ' + status);
+        if (worse > tolerance) {
+            regressions.push(key);
+        }
+    });
+    return regressions;
+};
+
+collect(function(metrics, failed) {
+    var result = {
+        date : new Date().toISOString(),
+        machine : machine(),
+        metrics : metrics
+    };
+    if (opts.out) {
+        fs.writeFileSync(opts.out, JSON.stringify(result, null, 2) + '\n');
+        console.log('wrote ' + opts.out);
+    }
+
+    var baseline = { tolerance : opts.tolerance, metrics : {} };
+    if (fs.existsSync(opts.baseline)) {
+        baseline = JSON.parse(fs.readFileSync(opts.baseline, 'utf8'));
+        baseline.metrics = baseline.metrics || {};
+    }
+
+    if (opts.update_baseline) {
+        // keep tolerances tuned by hand
+        Object.keys(metrics).forEach(function(key) {
+            var old = baseline.metrics[key];
+            baseline.metrics[key] = metrics[key];
+            if (old && old.tolerance !== undefined) {
+                baseline.metrics[key].tolerance = old.tolerance;
+            }
+        });
+        baseline.machine = result.machine;
+        baseline.date = result.date;
+        fs.writeFileSync(opts.baseline, JSON.stringify(baseline, null, 2) + '\n');
+        console.log('updated ' + opts.baseline);
+        return process.exit(failed.length ? 1 : 0);
+    }
+
+    if (baseline.machine && baseline.machine.cpu !== result.machine.cpu) {
+        console.log('warning: baseline was taken on ' + baseline.machine.cpu);
+    }
+    console.log('comparing with ' + opts.baseline);
+    var regressions = compare(metrics, baseline);
+    failed.forEach(function(f) {
+        console.error('FAIL: ' + f);
+    });
+    regressions.forEach(function(r) {
+        console.error('REGRESSION: ' + r);
+    });
+    process.exit(failed.length || regressions.length ? 1 : 0);
+});
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Soak test against a local responder.  Runs lookups, cancels and
+// context create / destroy cycles for a long time while sampling the
+// process memory and the binding's live object counts, and fails when
+// they keep growing.
+//
+//   node --expose-gc bench/soak.js [--duration=600] [--concurrency=200]
+//       [--cancel=0.1] [--churn=10] [--interval=10]
+//       [--max-rss-growth=32] [--max-heap-growth=16] [--json]
+//
+// --cancel is the fraction of lookups cancelled, --churn the contexts
+// created and destroyed per second.  Growth is measured between the
+// first samples after warm up and the last ones, in MB.  After the run
+// every query, context and event loop handle must be gone.  With
+// --expose-gc, GC is forced before each sample so that the samples show
+// retained memory rather than GC timing.
+
+var common = require('./lib/common'),
+    responder = require('./lib/responder');
+
+var getdns = common.getdns;
+
+var opts = common.parseArgs({
+    duration : 600,
+    concurrency : 200,
+    cancel : 0.1,
+    churn : 10,
+    interval : 10,
+    max_rss_growth : 32,
+    max_heap_growth : 16,
+    json : false
+});
+
+var MB = 1024 * 1024;
+
+var sample = function(contexts) {
+    if (global.gc) {
+        global.gc();
+    }
+    var mem = process.memoryUsage();
+    var nativeStats = getdns.nativeStats();
+    var external = 0;
+    // older node has no memoryUsage().external, so add up what the
+    // contexts report instead
+    if (mem.external === undefined) {
+        contexts.forEach(function(ctx) {
+            external += ctx.stats().memory.bytes_reported;
+        });
+    } else {
+        external = mem.external;
+    }
+    return {
+        time : Date.now(),
+        rss : mem.rss,
+        heap_used : mem.heapUsed,
+        external : external,
+        live_queries : nativeStats.live.queries,
+        live_contexts : nativeStats.live.contexts,
+        live_events : nativeStats.event_loop.live_events
+    };
+};
+
+var print = function(s, label) {
+    if (opts.json) {
+        s.label = label;
+        console.log(JSON.stringify(s));
+        return;
+    }
+    console.log(label + ' rss ' + (s.rss / MB).toFixed(1) + 'MB' +
+                ' heap ' + (s.heap_used / MB).toFixed(1) + 'MB' +
+                ' external ' + (s.external / MB).toFixed(1) + 'MB' +
+                ' queries ' + s.live_queries +
+                ' contexts ' + s.live_contexts +
+                ' events ' + s.live_events);
+};
+
+// mean of a field over samples
+var mean = function(samples, field) {
+    var sum = 0;
+    samples.forEach(function(s) {
+        sum += s[field];
+    });
+    return sum / samples.length;
+};
+
+var run = function(port, done) {
+    var ctx = common.stubContext(port);
+    var churned = [];
+    var issued = 0, completed = 0, cancelled = 0, churnCycles = 0;
+    var stopping = false, inFlight = 0;
+    var samples = [];
+
+    var issue = function() {
+        inFlight++;
+        var callback = function(err, result) {
+            inFlight--;
+            completed++;
+            if (err && err.code === getdns.CALLBACK_CANCEL) {
+                cancelled++;
+            }
+            if (!stopping) {
+                issue();
+            } else if (inFlight === 0) {
+                finish();
+            }
+        };
+        var name = common.queryName(issued++);
+        var transId = (issued % 2) ?
+            ctx.lookup(name, getdns.RRTYPE_A, callback) :
+            ctx.getAddress(name, callback);
+        if (Math.random() < opts.cancel) {
+            // cancel right away or once the query is on the wire
+            if (Math.random() < 0.5) {
+                ctx.cancel(transId);
+            } else {
+                setImmediate(function() {
+                    ctx.cancel(transId);
+                });
+            }
+        }
+    };
+
+    // create a context, make a query on it and destroy it
+    var churn = function() {
+        var c = common.stubContext(port);
+        churned.push(c);
+        c.getAddress(common.queryName(issued++), function() {
+            churned.splice(churned.indexOf(c), 1);
+            c.destroy();
+            churnCycles++;
+        });
+    };
+
+    var churnTimer = opts.churn > 0 ?
+        setInterval(churn, 1000 / opts.churn) : null;
+    var sampleTimer = setInterval(function() {
+        var s = sample([ ctx ].concat(churned));
+        samples.push(s);
+        print(s, 'sample ' + samples.length);
+    }, opts.interval * 1000);
+
+    for (var i = 0; i < opts.concurrency; ++i) {
+        issue();
+    }
+
+    setTimeout(function() {
+        stopping = true;
+        clearInterval(churnTimer);
+        clearInterval(sampleTimer);
+    }, opts.duration * 1000);
+
+    var finish = function() {
+        ctx.destroy();
+        // wait out the churned contexts and the deferred destroys
+        var wait = setInterval(function() {
+            if (churned.length > 0) {
+                return;
+            }
+            clearInterval(wait);
+            // drop the last references so the final sample can collect
+            // every context
+            ctx = null;
+            churned = null;
+            setTimeout(function() {
+                done({
+                    issued : issued,
+                    completed : completed,
+                    cancelled : cancelled,
+                    churn_cycles : churnCycles
+                }, samples, sample([]));
+            }, 500);
+        }, 100);
+    };
+};
+
+var check = function(totals, samples, end) {
+    var failures = [];
+    if (samples.length >= 4) {
+        // skip the warm up quarter, then compare the first and last quarters
+        var quarter = Math.floor(samples.length / 4);
+        var early = samples.slice(quarter, quarter * 2);
+        var late = samples.slice(samples.length - quarter);
+        var rssGrowth = (mean(late, 'rss') - mean(early, 'rss')) / MB;
+        var heapGrowth = (mean(late, 'heap_used') - mean(early, 'heap_used')) / MB;
+        var externalGrowth = (mean(late, 'external') - mean(early, 'external')) / MB;
+        console.log('growth rss ' + rssGrowth.toFixed(1) + 'MB heap ' +
+                    heapGrowth.toFixed(1) + 'MB external ' +
+                    externalGrowth.toFixed(1) + 'MB');
+        if (rssGrowth > opts.max_rss_growth) {
+            failures.push('rss grew ' + rssGrowth.toFixed(1) + 'MB');
+        }
+        if (heapGrowth + externalGrowth > opts.max_heap_growth) {
+            failures.push('heap and external memory grew ' +
+                          (heapGrowth + externalGrowth).toFixed(1) + 'MB');
+        }
+    } else {
+        console.log('too few samples to measure growth, raise --duration');
+    }
+    if (end.live_queries !== 0) {
+        failures.push(end.live_queries + ' queries still alive');
+    }
+    if (end.live_events !== 0) {
+        failures.push(end.live_events + ' event loop handles still open');
+    }
+    // contexts only go once collected
+    if (global.gc && end.live_contexts !== 0) {
+        failures.push(end.live_contexts + ' contexts still alive');
+    }
+    console.log('issued ' + totals.issued + ' completed ' + totals.completed +
+                ' cancelled ' + totals.cancelled +
+                ' context cycles ' + totals.churn_cycles);
+    return failures;
+};
+
+responder.fork({}, function(err, server) {
+    if (err) {
+        throw err;
+    }
+    run(server.port, function(totals, samples, end) {
+        server.close();
+        print(end, 'end');
+        var failures = check(totals, samples, end);
+        failures.forEach(function(f) {
+            console.error('FAIL: ' + f);
+        });
+        process.exit(failures.length ? 1 : 0);
+    });
+});
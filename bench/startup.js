@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Cold start cost.  Starts fresh node processes and measures, in each,
+// require('getdns'), creating the first context and its first lookup
+// against a local responder, plus the whole process against an empty
+// node process.  This is what short lived tools pay on every run.  The
+// measured process is bench/lib/coldstart.js.
+//
+//   node bench/startup.js [--runs=20] [--json]
+
+var child_process = require('child_process'),
+    path = require('path'),
+    common = require('./lib/common'),
+    responder = require('./lib/responder'),
+    report = require('./lib/report'),
+    Histogram = require('./lib/histogram');
+
+var opts = common.parseArgs({
+    runs : 20,
+    json : false
+});
+
+var millis = function(start) {
+    return common.elapsedMicros(start) / 1000;
+};
+
+// Run a node process and call back with its wall time and output
+var timeProcess = function(args, callback) {
+    var start = process.hrtime();
+    var proc = child_process.spawn(process.execPath, args, {
+        stdio : [ 'ignore', 'pipe', 'inherit' ]
+    });
+    var output = '';
+    proc.stdout.on('data', function(data) {
+        output += data;
+    });
+    proc.on('close', function(code) {
+        if (code !== 0) {
+            throw new Error(args.join(' ') + ' exited with ' + code);
+        }
+        callback(millis(start), output);
+    });
+};
+
+var run = function(port, done) {
+    var histograms = {
+        node_process : new Histogram(),
+        process : new Histogram(),
+        require : new Histogram(),
+        context : new Histogram(),
+        first_lookup : new Histogram()
+    };
+    var errors = 0;
+    var next = function(i) {
+        if (i === opts.runs) {
+            var result = { name : 'startup', runs : opts.runs, errors : errors };
+            Object.keys(histograms).forEach(function(k) {
+                result[k + '_ms'] = histograms[k].summary(1000);
+            });
+            return done(result);
+        }
+        timeProcess([ '-e', '' ], function(nodeMs) {
+            histograms.node_process.record(nodeMs * 1000);
+            var script = path.join(__dirname, 'lib', 'coldstart.js');
+            timeProcess([ script, String(port) ], function(ms, output) {
+                var r = JSON.parse(output);
+                histograms.process.record(ms * 1000);
+                histograms.require.record(r.require_ms * 1000);
+                histograms.context.record(r.context_ms * 1000);
+                histograms.first_lookup.record(r.first_lookup_ms * 1000);
+                if (r.error) {
+                    errors++;
+                }
+                next(i + 1);
+            });
+        });
+    };
+    next(0);
+};
+
+responder.fork({}, function(err, server) {
+    if (err) {
+        throw err;
+    }
+    run(server.port, function(result) {
+        server.close();
+        report.print(result, opts.json);
+    });
+});
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Bulk resolution through resolveStream against the same work done in JS:
+// lookup per name at the same concurrency and a JSON.stringify'd line per
+// result written to a file.  Names come from a generated file and answers
+// from the local responder.
+//
+//   node bench/stream.js [--names=100000] [--concurrency=500] [--json]
+
+var fs = require('fs'),
+    os = require('os'),
+    path = require('path'),
+    common = require('./lib/common'),
+    responder = require('./lib/responder'),
+    cpu = require('./lib/cpu'),
+    report = require('./lib/report');
+
+var getdns = common.getdns;
+
+var opts = common.parseArgs({
+    names : 100000,
+    concurrency : 500,
+    json : false
+});
+
+var base = path.join(os.tmpdir(), 'getdns-stream-' + process.pid);
+
+var writeNames = function() {
+    var names = [];
+    for (var i = 0; i < opts.names; ++i) {
+        names.push(common.queryName(i));
+    }
+    fs.writeFileSync(base + '.in', names.join('\n') + '\n');
+    return names;
+};
+
+var measure = function(name, start, startCpu, failed) {
+    var elapsed = common.elapsedMicros(start) / 1e6;
+    var used = cpu.since(startCpu);
+    return {
+        name : name,
+        names : opts.names,
+        failed : failed,
+        names_per_s : opts.names / elapsed,
+        cpu_us_per_name : (used.user + used.system) / opts.names,
+        output_bytes : fs.statSync(base + '.out').size
+    };
+};
+
+var runNative = function(port, done) {
+    var ctx = common.stubContext(port);
+    var inFd = fs.openSync(base + '.in', 'r');
+    var outFd = fs.openSync(base + '.out', 'w');
+    var start = process.hrtime(), startCpu = cpu.usage();
+    ctx.resolveStream(inFd, outFd, {
+        type : getdns.RRTYPE_A,
+        concurrency : opts.concurrency
+    }, function(err, summary) {
+        if (err) {
+            throw new Error(err.msg);
+        }
+        fs.closeSync(inFd);
+        fs.closeSync(outFd);
+        var result = measure('stream resolveStream', start, startCpu, summary.failed);
+        ctx.destroy();
+        done(result);
+    });
+};
+
+var runJs = function(port, names, done) {
+    var ctx = common.stubContext(port);
+    var out = fs.createWriteStream(base + '.out');
+    var start = process.hrtime(), startCpu = cpu.usage();
+    var issued = 0, completed = 0, failed = 0;
+    var issue = function() {
+        var name = names[issued++];
+        ctx.lookup(name, getdns.RRTYPE_A, function(err, result) {
+            completed++;
+            if (err) {
+                failed++;
+                out.write(JSON.stringify({ name : name, error : err }) + '\n');
+            } else {
+                delete result.replies_full;
+                out.write(JSON.stringify({ name : name, response : result }) + '\n');
+            }
+            if (issued < names.length) {
+                issue();
+            } else if (completed === names.length) {
+                out.end(function() {
+                    var r = measure('stream js', start, startCpu, failed);
+                    ctx.destroy();
+                    done(r);
+                });
+            }
+        });
+    };
+    for (var i = 0; i < opts.concurrency && i < names.length; ++i) {
+        issue();
+    }
+};
+
+var names = writeNames();
+responder.fork({}, function(err, server) {
+    if (err) {
+        throw err;
+    }
+    runNative(server.port, function(nativeResult) {
+        runJs(server.port, names, function(jsResult) {
+            server.close();
+            fs.unlinkSync(base + '.in');
+            fs.unlinkSync(base + '.out');
+            report.print(nativeResult, opts.json);
+            report.print(jsResult, opts.json);
+            if (!opts.json) {
+                console.log('cpu per name, js / native: ' +
+                            (jsResult.cpu_us_per_name / nativeResult.cpu_us_per_name).toFixed(2));
+            }
+        });
+    });
+});
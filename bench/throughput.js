@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Closed loop throughput against a local responder.  Keeps a fixed
+// number of lookups in flight for the duration and reports queries per
+// second, CPU time per query and the latency distribution.
+//
+//   node bench/throughput.js [--duration=10] [--warmup=1]
+//       [--concurrency=100] [--method=lookup|getAddress]
+//       [--transport=udp|tcp] [--json]
+
+var common = require('./lib/common'),
+    responder = require('./lib/responder'),
+    cpu = require('./lib/cpu'),
+    report = require('./lib/report'),
+    Histogram = require('./lib/histogram');
+
+var getdns = common.getdns;
+
+var opts = common.parseArgs({
+    duration : 10,
+    warmup : 1,
+    concurrency : 100,
+    method : 'lookup',
+    transport : 'udp',
+    json : false
+});
+
+var TRANSPORTS = {
+    udp : getdns.TRANSPORT_UDP_ONLY,
+    tcp : getdns.TRANSPORT_TCP_ONLY_KEEP_CONNECTIONS_OPEN
+};
+
+if (!(opts.transport in TRANSPORTS)) {
+    throw new Error('unknown transport ' + opts.transport);
+}
+if (opts.method !== 'lookup' && opts.method !== 'getAddress') {
+    throw new Error('unknown method ' + opts.method);
+}
+
+var run = function(port, done) {
+    var ctx = common.stubContext(port, {
+        dns_transport : TRANSPORTS[opts.transport]
+    });
+    var latency = new Histogram();
+    var issued = 0, completed = 0, errors = 0;
+    var measuring = false, stopping = false, inFlight = 0;
+    var startTime, startCpu, elapsed, used;
+
+    var issue = function() {
+        var start = process.hrtime();
+        var name = common.queryName(issued++);
+        var callback = function(err, result) {
+            inFlight--;
+            if (measuring) {
+                completed++;
+                if (err) {
+                    errors++;
+                }
+                latency.record(common.elapsedMicros(start));
+            }
+            if (!stopping) {
+                issue();
+            } else if (inFlight === 0) {
+                ctx.destroy();
+                done({
+                    name : 'throughput',
+                    method : opts.method,
+                    transport : opts.transport,
+                    concurrency : opts.concurrency,
+                    queries : completed,
+                    errors : errors,
+                    qps : completed / elapsed,
+                    cpu_us_per_query : completed ? (used.user + used.system) / completed : 0,
+                    cpu_user_s : used.user / 1e6,
+                    cpu_system_s : used.system / 1e6,
+                    latency_ms : latency.summary(1000)
+                });
+            }
+        };
+        inFlight++;
+        if (opts.method === 'lookup') {
+            ctx.lookup(name, getdns.RRTYPE_A, callback);
+        } else {
+            ctx.getAddress(name, callback);
+        }
+    };
+
+    for (var i = 0; i < opts.concurrency; ++i) {
+        issue();
+    }
+    setTimeout(function() {
+        measuring = true;
+        startTime = process.hrtime();
+        startCpu = cpu.usage();
+        setTimeout(function() {
+            // the tail still in flight is not part of the measurement
+            measuring = false;
+            stopping = true;
+            elapsed = common.elapsedMicros(startTime) / 1e6;
+            used = cpu.since(startCpu);
+        }, opts.duration * 1000);
+    }, opts.warmup * 1000);
+};
+
+responder.fork({}, function(err, server) {
+    if (err) {
+        throw err;
+    }
+    run(server.port, function(result) {
+        server.close();
+        report.print(result, opts.json);
+    });
+});
@@ -1,11 +1,24 @@
 {
+    "variables" : {
+        # USDT probes, see src/GNProbes.h
+        "with_usdt%" : "<!(test -f /usr/include/sys/sdt.h && echo true || echo false)",
+        # native benchmarks, see bench/native
+        "build_bench%" : "false"
+    },
     "targets" : [
         {
             "target_name" : "getdns",
             "sources" : [
                 "src/GNContext.cpp",
                 "src/GNUtil.cpp",
-                "src/GNConstants.cpp"
+                "src/GNLibuv.cpp",
+                "src/GNConstants.cpp",
+                "src/GNScheduler.cpp",
+                "src/GNStats.cpp",
+                "src/GNTrace.cpp",
+                "src/GNMemory.cpp",
+                "src/GNReplay.cpp",
+                "src/GNStream.cpp"
             ],
             "link_settings" : {
                 "libraries" : [
@@ -16,6 +29,9 @@
                 "<!(node -e \"require('nan')\")"
             ],
             "conditions": [
+                ["OS=='linux' and with_usdt=='true'", {
+                  "defines": [ "GN_ENABLE_USDT" ]
+                }],
                 ["OS=='mac' or OS=='solaris'", {
                   "xcode_settings": {
                     "GCC_ENABLE_CPP_EXCEPTIONS": "YES"
@@ -39,5 +55,91 @@
                 }]
             ]
         }
+    ],
+    "conditions" : [
+        ["build_bench=='true'", {
+            "targets" : [
+                {
+                    "target_name" : "getdns_bench",
+                    "sources" : [
+                        "bench/native/GNBench.cpp",
+                        "bench/native/GNStub.cpp",
+                        "src/GNContext.cpp",
+                        "src/GNUtil.cpp",
+                        "src/GNLibuv.cpp",
+                        "src/GNConstants.cpp",
+                        "src/GNScheduler.cpp",
+                        "src/GNStats.cpp",
+                        "src/GNTrace.cpp",
+                        "src/GNMemory.cpp",
+                        "src/GNReplay.cpp",
+                        "src/GNStream.cpp"
+                    ],
+                    "defines" : [ "GN_STUB_GETDNS", "GN_NO_MODULE" ],
+                    "link_settings" : {
+                        "libraries" : [
+                            "-lgetdns", "-lldns"
+                        ]
+                    },
+                    "include_dirs" : [
+                        "src",
+                        "bench/native",
+                        "<!(node -e \"require('nan')\")"
+                    ],
+                    "conditions": [
+                        ["OS=='mac' or OS=='solaris'", {
+                          "include_dirs": [
+                            "/opt/local/include",
+                            "/usr/local/include"
+                          ],
+                          "libraries": [
+                            "-L/opt/local/lib",
+                            "-L/usr/local/lib"
+                          ]
+                        }],
+                        ["OS=='openbsd' or OS=='freebsd'", {
+                          "include_dirs": [
+                            "/usr/local/include"
+                          ],
+                          "libraries": [
+                            "-L/usr/local/lib"
+                          ]
+                        }]
+                    ]
+                },
+                {
+                    "target_name" : "gn_responder",
+                    "type" : "executable",
+                    "sources" : [
+                        "bench/native/GNResponder.cpp"
+                    ],
+                    "link_settings" : {
+                        "libraries" : [
+                            "-lldns"
+                        ]
+                    },
+                    "conditions": [
+                        ["OS=='mac' or OS=='solaris'", {
+                          "include_dirs": [
+                            "/opt/local/include",
+                            "/usr/local/include"
+                          ],
+                          "libraries": [
+                            "-L/opt/local/lib",
+                            "-L/usr/local/lib"
+                          ]
+                        }],
+                        ["OS=='openbsd' or OS=='freebsd'", {
+                          "include_dirs": [
+                            "/usr/local/include"
+                          ],
+                          "libraries": [
+                            "-L/usr/local/lib"
+                          ]
+                        }]
+                    ]
+                }
+            ]
+        }]
     ]
-}
\ No newline at end of file
+}
@@ -30,6 +30,9 @@ var getdns = require("bindings")("getdns");
 // export constants directly
 module.exports = getdns.constants;
 
+// counters shared by all contexts
+module.exports.nativeStats = getdns.nativeStats;
+
 // wrap context creation
 module.exports.createContext = function(opts) {
     var ctx = new getdns.Context(opts);
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_CALLBACK_DATA_H_
+#define _GN_CALLBACK_DATA_H_
+
+#include <nan.h>
+#include <getdns/getdns.h>
+#include <uv.h>
+#include <string>
+
+class GNContext;
+
+// Enum to distinguish which getdns function issues a query.
+typedef enum LookupType {
+    GNAddress = 0,
+    GNHostname,
+    GNService,
+    GNGeneral
+} LookupType;
+
+// Callback data passed to getdns callback as userarg.  It also holds
+// everything needed to issue the query so the scheduler can hold it
+// back and issue it later.
+typedef struct CallbackData {
+    NanCallback* callback;
+    GNContext* ctx;
+
+    // the query
+    LookupType lookupType;
+    std::string name;
+    uint16_t type;
+    getdns_dict* extension;
+
+    // scheduling tags
+    std::string tenant;
+    uint32_t priority;
+    bool scheduled;
+
+    // uv_hrtime() at submission and when handed to getdns
+    uint64_t startTime;
+    uint64_t issueTime;
+
+    // per query deadline
+    uint32_t deadlineMs;
+    uv_timer_t* deadline;
+    bool timedOut;
+
+    // optional AbortSignal the query is registered with
+    v8::Persistent<v8::Object> signal;
+    bool hasSignal;
+    bool aborted;
+
+    // domain active when the query was made
+    v8::Persistent<v8::Object> domain;
+    bool hasDomain;
+
+    // id handed back to JS and the getdns transaction once issued.
+    // These are the same unless the query went through the scheduler.
+    uint64_t id;
+    getdns_transaction_t transId;
+    bool issued;
+
+    // getdns may call back before the call issuing the query returns.
+    // The callback then leaves the query for the issuer to free.
+    bool inIssue;
+    bool finished;
+} CallbackData;
+
+#endif
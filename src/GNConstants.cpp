@@ -31,172 +31,187 @@
 
 using namespace v8;
 
-static inline void SetConstant(const char* name, int value, Handle<Object> exports) {
-    exports->ForceSet(NanNew<String>(name), NanNew<Integer>(value), ReadOnly);
-}
+// Constants exported as getdns.<name> from GETDNS_<name>
+typedef struct GNConstant {
+    const char* name;
+    int value;
+} GNConstant;
 
-void GNConstants::Init(Handle<Object> target) {
+#define GN_CONSTANT(name) { #name, GETDNS_##name }
+
+static const GNConstant CONSTANTS[] = {
+    GN_CONSTANT(RETURN_GOOD),
+    GN_CONSTANT(RETURN_GENERIC_ERROR),
+    GN_CONSTANT(RETURN_BAD_DOMAIN_NAME),
+    GN_CONSTANT(RETURN_UNKNOWN_TRANSACTION),
+    GN_CONSTANT(RETURN_NO_SUCH_LIST_ITEM),
+    GN_CONSTANT(RETURN_NO_SUCH_DICT_NAME),
+    GN_CONSTANT(RETURN_WRONG_TYPE_REQUESTED),
+    GN_CONSTANT(RETURN_NO_SUCH_EXTENSION),
+    GN_CONSTANT(RETURN_EXTENSION_MISFORMAT),
+    GN_CONSTANT(RETURN_DNSSEC_WITH_STUB_DISALLOWED),
+    GN_CONSTANT(RETURN_MEMORY_ERROR),
+    GN_CONSTANT(RETURN_INVALID_PARAMETER),
+    GN_CONSTANT(DNSSEC_SECURE),
+    GN_CONSTANT(DNSSEC_BOGUS),
+    GN_CONSTANT(DNSSEC_INDETERMINATE),
+    GN_CONSTANT(DNSSEC_INSECURE),
+    GN_CONSTANT(DNSSEC_NOT_PERFORMED),
+    GN_CONSTANT(NAMESPACE_DNS),
+    GN_CONSTANT(NAMESPACE_LOCALNAMES),
+    GN_CONSTANT(NAMESPACE_NETBIOS),
+    GN_CONSTANT(NAMESPACE_MDNS),
+    GN_CONSTANT(NAMESPACE_NIS),
+    GN_CONSTANT(RESOLUTION_STUB),
+    GN_CONSTANT(RESOLUTION_RECURSING),
+    GN_CONSTANT(REDIRECTS_FOLLOW),
+    GN_CONSTANT(REDIRECTS_DO_NOT_FOLLOW),
+    GN_CONSTANT(TRANSPORT_UDP_FIRST_AND_FALL_BACK_TO_TCP),
+    GN_CONSTANT(TRANSPORT_UDP_ONLY),
+    GN_CONSTANT(TRANSPORT_TCP_ONLY),
+    GN_CONSTANT(TRANSPORT_TCP_ONLY_KEEP_CONNECTIONS_OPEN),
+    GN_CONSTANT(APPEND_NAME_ALWAYS),
+    GN_CONSTANT(APPEND_NAME_ONLY_TO_SINGLE_LABEL_AFTER_FAILURE),
+    GN_CONSTANT(APPEND_NAME_ONLY_TO_MULTIPLE_LABEL_NAME_AFTER_FAILURE),
+    GN_CONSTANT(APPEND_NAME_NEVER),
+    GN_CONSTANT(CALLBACK_COMPLETE),
+    GN_CONSTANT(CALLBACK_CANCEL),
+    GN_CONSTANT(CALLBACK_TIMEOUT),
+    GN_CONSTANT(CALLBACK_ERROR),
+    GN_CONSTANT(NAMETYPE_DNS),
+    GN_CONSTANT(NAMETYPE_WINS),
+    GN_CONSTANT(RESPSTATUS_GOOD),
+    GN_CONSTANT(RESPSTATUS_NO_NAME),
+    GN_CONSTANT(RESPSTATUS_ALL_TIMEOUT),
+    GN_CONSTANT(RESPSTATUS_NO_SECURE_ANSWERS),
+    GN_CONSTANT(RESPSTATUS_ALL_BOGUS_ANSWERS),
+    GN_CONSTANT(EXTENSION_TRUE),
+    GN_CONSTANT(EXTENSION_FALSE),
+    GN_CONSTANT(BAD_DNS_CNAME_IN_TARGET),
+    GN_CONSTANT(BAD_DNS_ALL_NUMERIC_LABEL),
+    GN_CONSTANT(BAD_DNS_CNAME_RETURNED_FOR_OTHER_TYPE),
+    GN_CONSTANT(RRTYPE_A),
+    GN_CONSTANT(RRTYPE_NS),
+    GN_CONSTANT(RRTYPE_MD),
+    GN_CONSTANT(RRTYPE_MF),
+    GN_CONSTANT(RRTYPE_CNAME),
+    GN_CONSTANT(RRTYPE_SOA),
+    GN_CONSTANT(RRTYPE_MB),
+    GN_CONSTANT(RRTYPE_MG),
+    GN_CONSTANT(RRTYPE_MR),
+    GN_CONSTANT(RRTYPE_NULL),
+    GN_CONSTANT(RRTYPE_WKS),
+    GN_CONSTANT(RRTYPE_PTR),
+    GN_CONSTANT(RRTYPE_HINFO),
+    GN_CONSTANT(RRTYPE_MINFO),
+    GN_CONSTANT(RRTYPE_MX),
+    GN_CONSTANT(RRTYPE_TXT),
+    GN_CONSTANT(RRTYPE_RP),
+    GN_CONSTANT(RRTYPE_AFSDB),
+    GN_CONSTANT(RRTYPE_X25),
+    GN_CONSTANT(RRTYPE_ISDN),
+    GN_CONSTANT(RRTYPE_RT),
+    GN_CONSTANT(RRTYPE_NSAP),
+    GN_CONSTANT(RRTYPE_SIG),
+    GN_CONSTANT(RRTYPE_KEY),
+    GN_CONSTANT(RRTYPE_PX),
+    GN_CONSTANT(RRTYPE_GPOS),
+    GN_CONSTANT(RRTYPE_AAAA),
+    GN_CONSTANT(RRTYPE_LOC),
+    GN_CONSTANT(RRTYPE_NXT),
+    GN_CONSTANT(RRTYPE_EID),
+    GN_CONSTANT(RRTYPE_NIMLOC),
+    GN_CONSTANT(RRTYPE_SRV),
+    GN_CONSTANT(RRTYPE_ATMA),
+    GN_CONSTANT(RRTYPE_NAPTR),
+    GN_CONSTANT(RRTYPE_KX),
+    GN_CONSTANT(RRTYPE_CERT),
+    GN_CONSTANT(RRTYPE_A6),
+    GN_CONSTANT(RRTYPE_DNAME),
+    GN_CONSTANT(RRTYPE_SINK),
+    GN_CONSTANT(RRTYPE_OPT),
+    GN_CONSTANT(RRTYPE_APL),
+    GN_CONSTANT(RRTYPE_DS),
+    GN_CONSTANT(RRTYPE_SSHFP),
+    GN_CONSTANT(RRTYPE_IPSECKEY),
+    GN_CONSTANT(RRTYPE_RRSIG),
+    GN_CONSTANT(RRTYPE_NSEC),
+    GN_CONSTANT(RRTYPE_DNSKEY),
+    GN_CONSTANT(RRTYPE_DHCID),
+    GN_CONSTANT(RRTYPE_NSEC3),
+    GN_CONSTANT(RRTYPE_NSEC3PARAM),
+    GN_CONSTANT(RRTYPE_TLSA),
+    GN_CONSTANT(RRTYPE_HIP),
+    GN_CONSTANT(RRTYPE_NINFO),
+    GN_CONSTANT(RRTYPE_RKEY),
+    GN_CONSTANT(RRTYPE_TALINK),
+    GN_CONSTANT(RRTYPE_CDS),
+    GN_CONSTANT(RRTYPE_CDNSKEY),
+    GN_CONSTANT(RRTYPE_OPENPGPKEY),
+    GN_CONSTANT(RRTYPE_SPF),
+    GN_CONSTANT(RRTYPE_UINFO),
+    GN_CONSTANT(RRTYPE_UID),
+    GN_CONSTANT(RRTYPE_GID),
+    GN_CONSTANT(RRTYPE_UNSPEC),
+    GN_CONSTANT(RRTYPE_NID),
+    GN_CONSTANT(RRTYPE_L32),
+    GN_CONSTANT(RRTYPE_L64),
+    GN_CONSTANT(RRTYPE_LP),
+    GN_CONSTANT(RRTYPE_EUI48),
+    GN_CONSTANT(RRTYPE_EUI64),
+    GN_CONSTANT(RRTYPE_TKEY),
+    GN_CONSTANT(RRTYPE_TSIG),
+    GN_CONSTANT(RRTYPE_IXFR),
+    GN_CONSTANT(RRTYPE_AXFR),
+    GN_CONSTANT(RRTYPE_MAILB),
+    GN_CONSTANT(RRTYPE_MAILA),
+    GN_CONSTANT(RRTYPE_ANY),
+    GN_CONSTANT(RRTYPE_URI),
+    GN_CONSTANT(RRTYPE_CAA),
+    GN_CONSTANT(RRTYPE_TA),
+    GN_CONSTANT(RRTYPE_DLV),
+    GN_CONSTANT(RRCLASS_IN),
+    GN_CONSTANT(RRCLASS_CH),
+    GN_CONSTANT(RRCLASS_HS),
+    GN_CONSTANT(RRCLASS_NONE),
+    GN_CONSTANT(RRCLASS_ANY),
+    GN_CONSTANT(OPCODE_QUERY),
+    GN_CONSTANT(OPCODE_IQUERY),
+    GN_CONSTANT(OPCODE_STATUS),
+    GN_CONSTANT(OPCODE_NOTIFY),
+    GN_CONSTANT(OPCODE_UPDATE),
+    GN_CONSTANT(RCODE_NOERROR),
+    GN_CONSTANT(RCODE_FORMERR),
+    GN_CONSTANT(RCODE_SERVFAIL),
+    GN_CONSTANT(RCODE_NXDOMAIN),
+    GN_CONSTANT(RCODE_NOTIMP),
+    GN_CONSTANT(RCODE_REFUSED),
+    GN_CONSTANT(RCODE_YXDOMAIN),
+    GN_CONSTANT(RCODE_YXRRSET),
+    GN_CONSTANT(RCODE_NXRRSET),
+    GN_CONSTANT(RCODE_NOTAUTH),
+    GN_CONSTANT(RCODE_NOTZONE),
+    GN_CONSTANT(RCODE_BADVERS),
+    GN_CONSTANT(RCODE_BADSIG),
+    GN_CONSTANT(RCODE_BADKEY),
+    GN_CONSTANT(RCODE_BADTIME),
+    GN_CONSTANT(RCODE_BADMODE),
+    GN_CONSTANT(RCODE_BADNAME),
+    GN_CONSTANT(RCODE_BADALG),
+    GN_CONSTANT(RCODE_BADTRUNC)
+};
 
-    Local<Object> exports = NanNew<Object>();
-    target->ForceSet(NanNew<String>("constants"), exports, ReadOnly);
+#undef GN_CONSTANT
 
-    SetConstant("RETURN_GOOD",GETDNS_RETURN_GOOD,exports);
-    SetConstant("RETURN_GENERIC_ERROR",GETDNS_RETURN_GENERIC_ERROR,exports);
-    SetConstant("RETURN_BAD_DOMAIN_NAME",GETDNS_RETURN_BAD_DOMAIN_NAME,exports);
-    SetConstant("RETURN_UNKNOWN_TRANSACTION",GETDNS_RETURN_UNKNOWN_TRANSACTION,exports);
-    SetConstant("RETURN_NO_SUCH_LIST_ITEM",GETDNS_RETURN_NO_SUCH_LIST_ITEM,exports);
-    SetConstant("RETURN_NO_SUCH_DICT_NAME",GETDNS_RETURN_NO_SUCH_DICT_NAME,exports);
-    SetConstant("RETURN_WRONG_TYPE_REQUESTED",GETDNS_RETURN_WRONG_TYPE_REQUESTED,exports);
-    SetConstant("RETURN_NO_SUCH_EXTENSION",GETDNS_RETURN_NO_SUCH_EXTENSION,exports);
-    SetConstant("RETURN_EXTENSION_MISFORMAT",GETDNS_RETURN_EXTENSION_MISFORMAT,exports);
-    SetConstant("RETURN_DNSSEC_WITH_STUB_DISALLOWED",GETDNS_RETURN_DNSSEC_WITH_STUB_DISALLOWED,exports);
-    SetConstant("RETURN_MEMORY_ERROR",GETDNS_RETURN_MEMORY_ERROR,exports);
-    SetConstant("RETURN_INVALID_PARAMETER",GETDNS_RETURN_INVALID_PARAMETER,exports);
-    SetConstant("DNSSEC_SECURE",GETDNS_DNSSEC_SECURE,exports);
-    SetConstant("DNSSEC_BOGUS",GETDNS_DNSSEC_BOGUS,exports);
-    SetConstant("DNSSEC_INDETERMINATE",GETDNS_DNSSEC_INDETERMINATE,exports);
-    SetConstant("DNSSEC_INSECURE",GETDNS_DNSSEC_INSECURE,exports);
-    SetConstant("DNSSEC_NOT_PERFORMED",GETDNS_DNSSEC_NOT_PERFORMED,exports);
-    SetConstant("NAMESPACE_DNS",GETDNS_NAMESPACE_DNS,exports);
-    SetConstant("NAMESPACE_LOCALNAMES",GETDNS_NAMESPACE_LOCALNAMES,exports);
-    SetConstant("NAMESPACE_NETBIOS",GETDNS_NAMESPACE_NETBIOS,exports);
-    SetConstant("NAMESPACE_MDNS",GETDNS_NAMESPACE_MDNS,exports);
-    SetConstant("NAMESPACE_NIS",GETDNS_NAMESPACE_NIS,exports);
-    SetConstant("RESOLUTION_STUB",GETDNS_RESOLUTION_STUB,exports);
-    SetConstant("RESOLUTION_RECURSING",GETDNS_RESOLUTION_RECURSING,exports);
-    SetConstant("REDIRECTS_FOLLOW",GETDNS_REDIRECTS_FOLLOW,exports);
-    SetConstant("REDIRECTS_DO_NOT_FOLLOW",GETDNS_REDIRECTS_DO_NOT_FOLLOW,exports);
-    SetConstant("TRANSPORT_UDP_FIRST_AND_FALL_BACK_TO_TCP",GETDNS_TRANSPORT_UDP_FIRST_AND_FALL_BACK_TO_TCP,exports);
-    SetConstant("TRANSPORT_UDP_ONLY",GETDNS_TRANSPORT_UDP_ONLY,exports);
-    SetConstant("TRANSPORT_TCP_ONLY",GETDNS_TRANSPORT_TCP_ONLY,exports);
-    SetConstant("TRANSPORT_TCP_ONLY_KEEP_CONNECTIONS_OPEN",GETDNS_TRANSPORT_TCP_ONLY_KEEP_CONNECTIONS_OPEN,exports);
-    SetConstant("APPEND_NAME_ALWAYS",GETDNS_APPEND_NAME_ALWAYS,exports);
-    SetConstant("APPEND_NAME_ONLY_TO_SINGLE_LABEL_AFTER_FAILURE",GETDNS_APPEND_NAME_ONLY_TO_SINGLE_LABEL_AFTER_FAILURE,exports);
-    SetConstant("APPEND_NAME_ONLY_TO_MULTIPLE_LABEL_NAME_AFTER_FAILURE",GETDNS_APPEND_NAME_ONLY_TO_MULTIPLE_LABEL_NAME_AFTER_FAILURE,exports);
-    SetConstant("APPEND_NAME_NEVER",GETDNS_APPEND_NAME_NEVER,exports);
-    SetConstant("CALLBACK_COMPLETE",GETDNS_CALLBACK_COMPLETE,exports);
-    SetConstant("CALLBACK_CANCEL",GETDNS_CALLBACK_CANCEL,exports);
-    SetConstant("CALLBACK_TIMEOUT",GETDNS_CALLBACK_TIMEOUT,exports);
-    SetConstant("CALLBACK_ERROR",GETDNS_CALLBACK_ERROR,exports);
-    SetConstant("NAMETYPE_DNS",GETDNS_NAMETYPE_DNS,exports);
-    SetConstant("NAMETYPE_WINS",GETDNS_NAMETYPE_WINS,exports);
-    SetConstant("RESPSTATUS_GOOD",GETDNS_RESPSTATUS_GOOD,exports);
-    SetConstant("RESPSTATUS_NO_NAME",GETDNS_RESPSTATUS_NO_NAME,exports);
-    SetConstant("RESPSTATUS_ALL_TIMEOUT",GETDNS_RESPSTATUS_ALL_TIMEOUT,exports);
-    SetConstant("RESPSTATUS_NO_SECURE_ANSWERS",GETDNS_RESPSTATUS_NO_SECURE_ANSWERS,exports);
-    SetConstant("RESPSTATUS_ALL_BOGUS_ANSWERS",GETDNS_RESPSTATUS_ALL_BOGUS_ANSWERS,exports);
-    SetConstant("EXTENSION_TRUE",GETDNS_EXTENSION_TRUE,exports);
-    SetConstant("EXTENSION_FALSE",GETDNS_EXTENSION_FALSE,exports);
-    SetConstant("BAD_DNS_CNAME_IN_TARGET",GETDNS_BAD_DNS_CNAME_IN_TARGET,exports);
-    SetConstant("BAD_DNS_ALL_NUMERIC_LABEL",GETDNS_BAD_DNS_ALL_NUMERIC_LABEL,exports);
-    SetConstant("BAD_DNS_CNAME_RETURNED_FOR_OTHER_TYPE",GETDNS_BAD_DNS_CNAME_RETURNED_FOR_OTHER_TYPE,exports);
-    SetConstant("RRTYPE_A",GETDNS_RRTYPE_A,exports);
-    SetConstant("RRTYPE_NS",GETDNS_RRTYPE_NS,exports);
-    SetConstant("RRTYPE_MD",GETDNS_RRTYPE_MD,exports);
-    SetConstant("RRTYPE_MF",GETDNS_RRTYPE_MF,exports);
-    SetConstant("RRTYPE_CNAME",GETDNS_RRTYPE_CNAME,exports);
-    SetConstant("RRTYPE_SOA",GETDNS_RRTYPE_SOA,exports);
-    SetConstant("RRTYPE_MB",GETDNS_RRTYPE_MB,exports);
-    SetConstant("RRTYPE_MG",GETDNS_RRTYPE_MG,exports);
-    SetConstant("RRTYPE_MR",GETDNS_RRTYPE_MR,exports);
-    SetConstant("RRTYPE_NULL",GETDNS_RRTYPE_NULL,exports);
-    SetConstant("RRTYPE_WKS",GETDNS_RRTYPE_WKS,exports);
-    SetConstant("RRTYPE_PTR",GETDNS_RRTYPE_PTR,exports);
-    SetConstant("RRTYPE_HINFO",GETDNS_RRTYPE_HINFO,exports);
-    SetConstant("RRTYPE_MINFO",GETDNS_RRTYPE_MINFO,exports);
-    SetConstant("RRTYPE_MX",GETDNS_RRTYPE_MX,exports);
-    SetConstant("RRTYPE_TXT",GETDNS_RRTYPE_TXT,exports);
-    SetConstant("RRTYPE_RP",GETDNS_RRTYPE_RP,exports);
-    SetConstant("RRTYPE_AFSDB",GETDNS_RRTYPE_AFSDB,exports);
-    SetConstant("RRTYPE_X25",GETDNS_RRTYPE_X25,exports);
-    SetConstant("RRTYPE_ISDN",GETDNS_RRTYPE_ISDN,exports);
-    SetConstant("RRTYPE_RT",GETDNS_RRTYPE_RT,exports);
-    SetConstant("RRTYPE_NSAP",GETDNS_RRTYPE_NSAP,exports);
-    SetConstant("RRTYPE_SIG",GETDNS_RRTYPE_SIG,exports);
-    SetConstant("RRTYPE_KEY",GETDNS_RRTYPE_KEY,exports);
-    SetConstant("RRTYPE_PX",GETDNS_RRTYPE_PX,exports);
-    SetConstant("RRTYPE_GPOS",GETDNS_RRTYPE_GPOS,exports);
-    SetConstant("RRTYPE_AAAA",GETDNS_RRTYPE_AAAA,exports);
-    SetConstant("RRTYPE_LOC",GETDNS_RRTYPE_LOC,exports);
-    SetConstant("RRTYPE_NXT",GETDNS_RRTYPE_NXT,exports);
-    SetConstant("RRTYPE_EID",GETDNS_RRTYPE_EID,exports);
-    SetConstant("RRTYPE_NIMLOC",GETDNS_RRTYPE_NIMLOC,exports);
-    SetConstant("RRTYPE_SRV",GETDNS_RRTYPE_SRV,exports);
-    SetConstant("RRTYPE_ATMA",GETDNS_RRTYPE_ATMA,exports);
-    SetConstant("RRTYPE_NAPTR",GETDNS_RRTYPE_NAPTR,exports);
-    SetConstant("RRTYPE_KX",GETDNS_RRTYPE_KX,exports);
-    SetConstant("RRTYPE_CERT",GETDNS_RRTYPE_CERT,exports);
-    SetConstant("RRTYPE_A6",GETDNS_RRTYPE_A6,exports);
-    SetConstant("RRTYPE_DNAME",GETDNS_RRTYPE_DNAME,exports);
-    SetConstant("RRTYPE_SINK",GETDNS_RRTYPE_SINK,exports);
-    SetConstant("RRTYPE_OPT",GETDNS_RRTYPE_OPT,exports);
-    SetConstant("RRTYPE_APL",GETDNS_RRTYPE_APL,exports);
-    SetConstant("RRTYPE_DS",GETDNS_RRTYPE_DS,exports);
-    SetConstant("RRTYPE_SSHFP",GETDNS_RRTYPE_SSHFP,exports);
-    SetConstant("RRTYPE_IPSECKEY",GETDNS_RRTYPE_IPSECKEY,exports);
-    SetConstant("RRTYPE_RRSIG",GETDNS_RRTYPE_RRSIG,exports);
-    SetConstant("RRTYPE_NSEC",GETDNS_RRTYPE_NSEC,exports);
-    SetConstant("RRTYPE_DNSKEY",GETDNS_RRTYPE_DNSKEY,exports);
-    SetConstant("RRTYPE_DHCID",GETDNS_RRTYPE_DHCID,exports);
-    SetConstant("RRTYPE_NSEC3",GETDNS_RRTYPE_NSEC3,exports);
-    SetConstant("RRTYPE_NSEC3PARAM",GETDNS_RRTYPE_NSEC3PARAM,exports);
-    SetConstant("RRTYPE_TLSA",GETDNS_RRTYPE_TLSA,exports);
-    SetConstant("RRTYPE_HIP",GETDNS_RRTYPE_HIP,exports);
-    SetConstant("RRTYPE_NINFO",GETDNS_RRTYPE_NINFO,exports);
-    SetConstant("RRTYPE_RKEY",GETDNS_RRTYPE_RKEY,exports);
-    SetConstant("RRTYPE_TALINK",GETDNS_RRTYPE_TALINK,exports);
-    SetConstant("RRTYPE_CDS",GETDNS_RRTYPE_CDS,exports);
-    SetConstant("RRTYPE_CDNSKEY",GETDNS_RRTYPE_CDNSKEY,exports);
-    SetConstant("RRTYPE_OPENPGPKEY",GETDNS_RRTYPE_OPENPGPKEY,exports);
-    SetConstant("RRTYPE_SPF",GETDNS_RRTYPE_SPF,exports);
-    SetConstant("RRTYPE_UINFO",GETDNS_RRTYPE_UINFO,exports);
-    SetConstant("RRTYPE_UID",GETDNS_RRTYPE_UID,exports);
-    SetConstant("RRTYPE_GID",GETDNS_RRTYPE_GID,exports);
-    SetConstant("RRTYPE_UNSPEC",GETDNS_RRTYPE_UNSPEC,exports);
-    SetConstant("RRTYPE_NID",GETDNS_RRTYPE_NID,exports);
-    SetConstant("RRTYPE_L32",GETDNS_RRTYPE_L32,exports);
-    SetConstant("RRTYPE_L64",GETDNS_RRTYPE_L64,exports);
-    SetConstant("RRTYPE_LP",GETDNS_RRTYPE_LP,exports);
-    SetConstant("RRTYPE_EUI48",GETDNS_RRTYPE_EUI48,exports);
-    SetConstant("RRTYPE_EUI64",GETDNS_RRTYPE_EUI64,exports);
-    SetConstant("RRTYPE_TKEY",GETDNS_RRTYPE_TKEY,exports);
-    SetConstant("RRTYPE_TSIG",GETDNS_RRTYPE_TSIG,exports);
-    SetConstant("RRTYPE_IXFR",GETDNS_RRTYPE_IXFR,exports);
-    SetConstant("RRTYPE_AXFR",GETDNS_RRTYPE_AXFR,exports);
-    SetConstant("RRTYPE_MAILB",GETDNS_RRTYPE_MAILB,exports);
-    SetConstant("RRTYPE_MAILA",GETDNS_RRTYPE_MAILA,exports);
-    SetConstant("RRTYPE_ANY",GETDNS_RRTYPE_ANY,exports);
-    SetConstant("RRTYPE_URI",GETDNS_RRTYPE_URI,exports);
-    SetConstant("RRTYPE_CAA",GETDNS_RRTYPE_CAA,exports);
-    SetConstant("RRTYPE_TA",GETDNS_RRTYPE_TA,exports);
-    SetConstant("RRTYPE_DLV",GETDNS_RRTYPE_DLV,exports);
-    SetConstant("RRCLASS_IN",GETDNS_RRCLASS_IN,exports);
-    SetConstant("RRCLASS_CH",GETDNS_RRCLASS_CH,exports);
-    SetConstant("RRCLASS_HS",GETDNS_RRCLASS_HS,exports);
-    SetConstant("RRCLASS_NONE",GETDNS_RRCLASS_NONE,exports);
-    SetConstant("RRCLASS_ANY",GETDNS_RRCLASS_ANY,exports);
-    SetConstant("OPCODE_QUERY",GETDNS_OPCODE_QUERY,exports);
-    SetConstant("OPCODE_IQUERY",GETDNS_OPCODE_IQUERY,exports);
-    SetConstant("OPCODE_STATUS",GETDNS_OPCODE_STATUS,exports);
-    SetConstant("OPCODE_NOTIFY",GETDNS_OPCODE_NOTIFY,exports);
-    SetConstant("OPCODE_UPDATE",GETDNS_OPCODE_UPDATE,exports);
-    SetConstant("RCODE_NOERROR",GETDNS_RCODE_NOERROR,exports);
-    SetConstant("RCODE_FORMERR",GETDNS_RCODE_FORMERR,exports);
-    SetConstant("RCODE_SERVFAIL",GETDNS_RCODE_SERVFAIL,exports);
-    SetConstant("RCODE_NXDOMAIN",GETDNS_RCODE_NXDOMAIN,exports);
-    SetConstant("RCODE_NOTIMP",GETDNS_RCODE_NOTIMP,exports);
-    SetConstant("RCODE_REFUSED",GETDNS_RCODE_REFUSED,exports);
-    SetConstant("RCODE_YXDOMAIN",GETDNS_RCODE_YXDOMAIN,exports);
-    SetConstant("RCODE_YXRRSET",GETDNS_RCODE_YXRRSET,exports);
-    SetConstant("RCODE_NXRRSET",GETDNS_RCODE_NXRRSET,exports);
-    SetConstant("RCODE_NOTAUTH",GETDNS_RCODE_NOTAUTH,exports);
-    SetConstant("RCODE_NOTZONE",GETDNS_RCODE_NOTZONE,exports);
-    SetConstant("RCODE_BADVERS",GETDNS_RCODE_BADVERS,exports);
-    SetConstant("RCODE_BADSIG",GETDNS_RCODE_BADSIG,exports);
-    SetConstant("RCODE_BADKEY",GETDNS_RCODE_BADKEY,exports);
-    SetConstant("RCODE_BADTIME",GETDNS_RCODE_BADTIME,exports);
-    SetConstant("RCODE_BADMODE",GETDNS_RCODE_BADMODE,exports);
-    SetConstant("RCODE_BADNAME",GETDNS_RCODE_BADNAME,exports);
-    SetConstant("RCODE_BADALG",GETDNS_RCODE_BADALG,exports);
-    SetConstant("RCODE_BADTRUNC",GETDNS_RCODE_BADTRUNC,exports);
+static const size_t NUM_CONSTANTS = sizeof(CONSTANTS) / sizeof(GNConstant);
+
+void GNConstants::Init(Handle<Object> target) {
+    // One template so the exports object is created with all of its
+    // properties at once rather than reshaped by a ForceSet for each
+    Local<ObjectTemplate> tpl = NanNew<ObjectTemplate>();
+    for (size_t i = 0; i < NUM_CONSTANTS; ++i) {
+        tpl->Set(NanNew<String>(CONSTANTS[i].name),
+                 NanNew<Integer>(CONSTANTS[i].value), ReadOnly);
+    }
+    target->ForceSet(NanNew<String>("constants"), tpl->NewInstance(), ReadOnly);
 }
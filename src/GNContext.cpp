@@ -28,6 +28,9 @@
 #include "GNContext.h"
 #include "GNUtil.h"
 #include "GNConstants.h"
+#include "GNProbes.h"
+#include "GNLibuv.h"
+#include "GNStream.h"
 
 #include <getdns/getdns_extra.h>
 #include <arpa/inet.h>
@@ -35,21 +38,42 @@
 #include <string.h>
 #include <nan.h>
 #include <sys/time.h>
+#include <uv.h>
+
+#ifdef GN_STUB_GETDNS
+// benchmarks only, see bench/native/GNStub.h
+#include "GNStub.h"
+#endif
 
 using namespace v8;
 
-// Enum to distinguish which helper is being used.
-typedef enum LookupType {
-    GNAddress = 0,
-    GNHostname,
-    GNService
-} LookupType;
+// Extension keys consumed by the binding and never passed to getdns
+static const char* BINDING_EXTENSIONS[] = {
+    "tenant",
+    "priority",
+    "deadline",
+    "signal",
+    NULL
+};
+
+// Options implemented by the binding rather than getdns
+static const char* BINDING_OPTIONS[] = {
+    "max_in_flight",
+    "tenant_weights",
+    "upstream_stats",
+    "trace",
+    "memory_pool",
+    "record",
+    "replay"
+};
+
+// Names in flight for resolveStream without a concurrency option
+static const uint32_t DEFAULT_STREAM_WINDOW = 100;
+
+// Trace ring capacity for trace : true
+static const size_t DEFAULT_TRACE_CAPACITY = 4096;
 
-// Callback data passed to getdns callback as userarg
-typedef struct CallbackData {
-    NanCallback* callback;
-    GNContext* ctx;
-} CallbackData;
+static size_t NUM_BINDING_OPTIONS = sizeof(BINDING_OPTIONS) / sizeof(const char*);
 
 // Helper to create an error object for lookup callbacks
 static Handle<Value> makeErrorObj(const char* msg, int code) {
@@ -59,6 +83,15 @@ static Handle<Value> makeErrorObj(const char* msg, int code) {
     return obj;
 }
 
+// Helper to create the error object for a query that missed its deadline
+static Handle<Value> makeTimeoutErrorObj(CallbackData* data) {
+    Handle<Object> obj = makeErrorObj("Query deadline expired.",
+                                      GETDNS_CALLBACK_TIMEOUT)->ToObject();
+    double elapsed = (uv_hrtime() - data->startTime) / 1e6;
+    obj->Set(NanNew<String>("elapsed"), NanNew<Number>(elapsed));
+    return obj;
+}
+
 // Helper to create an address dictionary from string
 // Must be freed by the user
 static getdns_dict* getdns_util_create_ip(const char* ip) {
@@ -208,6 +241,33 @@ static OptionSetter SETTERS[] = {
 
 static size_t NUM_SETTERS = sizeof(SETTERS) / sizeof(OptionSetter);
 
+// Options deciding where queries go, which replay overrides, and the
+// context setting each one changes
+typedef struct RoutingOption {
+    const char* opt_name;
+    const char* setting;
+} RoutingOption;
+
+static RoutingOption ROUTING_OPTIONS[] = {
+    { "stub", "resolution_type" },
+    { "upstreams", "upstream_recursive_servers" },
+    { "upstream_recursive_servers", "upstream_recursive_servers" },
+    { "dns_transport", "dns_transport" },
+    { "resolution_type", "resolution_type" }
+};
+
+static size_t NUM_ROUTING_OPTIONS = sizeof(ROUTING_OPTIONS) / sizeof(RoutingOption);
+
+// The context setting a routing option changes, NULL for other options
+static const char* routingSetting(const char* name) {
+    for (size_t i = 0; i < NUM_ROUTING_OPTIONS; ++i) {
+        if (strcmp(ROUTING_OPTIONS[i].opt_name, name) == 0) {
+            return ROUTING_OPTIONS[i].setting;
+        }
+    }
+    return NULL;
+}
+
 typedef struct Uint8OptionSetter {
     const char* opt_name;
     getdns_context_uint8_t_setter setter;
@@ -234,6 +294,329 @@ static Uint16OptionSetter UINT16_OPTION_SETTERS[] = {
 static size_t NUM_UINT16_SETTERS = sizeof(UINT16_OPTION_SETTERS) / sizeof(Uint16OptionSetter);
 
 // End setters
+
+// Read the binding level extensions out of the extension object
+static void readBindingExtensions(Handle<Object> ext, CallbackData* data) {
+    Local<Value> tenant = ext->Get(NanNew<String>("tenant"));
+    if (!tenant->IsUndefined() && !tenant->IsNull()) {
+        NanUtf8String tenantStr(tenant->ToString());
+        data->tenant = *tenantStr;
+    }
+    Local<Value> priority = ext->Get(NanNew<String>("priority"));
+    if (priority->IsNumber()) {
+        data->priority = priority->Uint32Value();
+    }
+    Local<Value> deadline = ext->Get(NanNew<String>("deadline"));
+    if (deadline->IsNumber()) {
+        data->deadlineMs = deadline->Uint32Value();
+    }
+    Local<Value> signal = ext->Get(NanNew<String>("signal"));
+    if (signal->IsObject()) {
+        NanAssignPersistent(data->signal, signal->ToObject());
+        data->hasSignal = true;
+    }
+}
+
+bool GNContext::SetBindingOption(GNContext* ctx, const char* name,
+                                 Handle<Value> value) {
+    if (strcmp(name, "max_in_flight") == 0) {
+        if (value->IsNumber()) {
+            ctx->scheduler_.setLimit(value->Uint32Value());
+            // a raised (or removed) limit may free up budget
+            ctx->Pump();
+        }
+        return true;
+    } else if (strcmp(name, "tenant_weights") == 0) {
+        if (GNUtil::isDictionaryObject(value)) {
+            ctx->scheduler_.clearWeights();
+            Local<Object> weights = value->ToObject();
+            Local<Array> names = weights->GetOwnPropertyNames();
+            for (uint32_t i = 0; i < names->Length(); ++i) {
+                Local<Value> tenant = names->Get(i);
+                Local<Value> weight = weights->Get(tenant);
+                if (weight->IsNumber()) {
+                    NanUtf8String tenantStr(tenant);
+                    ctx->scheduler_.setWeight(*tenantStr, weight->Uint32Value());
+                }
+            }
+        }
+        return true;
+    } else if (strcmp(name, "trace") == 0) {
+        if (value->IsNumber()) {
+            ctx->trace_.setCapacity(value->Uint32Value());
+        } else {
+            ctx->trace_.setCapacity(value->IsTrue() ? DEFAULT_TRACE_CAPACITY : 0);
+        }
+        return true;
+    } else if (strcmp(name, "memory_pool") == 0) {
+        ctx->allocator_.setPooling(value->IsTrue());
+        return true;
+    } else if (strcmp(name, "record") == 0) {
+        if (value->IsString()) {
+            NanUtf8String path(value);
+            if (!ctx->recorder_.open(*path)) {
+                NanThrowError("Unable to open the record file.");
+            }
+        } else {
+            ctx->recorder_.close();
+        }
+        return true;
+    } else if (strcmp(name, "replay") == 0) {
+        if (ctx->replay_) {
+            ctx->replay_->close();
+            ctx->replay_ = NULL;
+        }
+        if (value->IsString()) {
+            NanUtf8String path(value);
+            std::string error;
+            ctx->replay_ = GNReplayServer::start(*path, &error);
+            if (!ctx->replay_) {
+                ctx->RestoreRouting();
+                NanThrowError(error.c_str());
+            } else {
+                // keep what was in place before replay, not a previous
+                // replay server
+                if (!ctx->savedRouting_) {
+                    ctx->SaveRouting(NULL);
+                }
+                ctx->UseReplayServer();
+            }
+        } else {
+            ctx->RestoreRouting();
+        }
+        return true;
+    } else if (strcmp(name, "upstream_stats") == 0) {
+        ctx->upstreamStatsEnabled_ = value->IsTrue();
+        return true;
+    } else if (strcmp(name, "upstreams") == 0 ||
+               strcmp(name, "upstream_recursive_servers") == 0) {
+        // remember the upstreams for per upstream stats but let the
+        // getdns setter handle them too
+        ctx->ConfigureUpstreamStats(value);
+        return false;
+    }
+    return false;
+}
+
+// Parse an IP string into its address bytes.  Returns the size or 0.
+static size_t parseIp(const char* ip, uint8_t* addr) {
+    if (inet_pton(AF_INET, ip, addr) == 1) {
+        return 4;
+    } else if (inet_pton(AF_INET6, ip, addr) == 1) {
+        return 16;
+    }
+    return 0;
+}
+
+// Copy the settings replay overrides from the context, or only setting
+// when given, so RestoreRouting can put them back
+void GNContext::SaveRouting(const char* setting) {
+    getdns_dict* info = getdns_context_get_api_information(context_);
+    getdns_dict* all = NULL;
+    if (!info) {
+        return;
+    }
+    if (getdns_dict_get_dict(info, "all_context", &all) == GETDNS_RETURN_GOOD) {
+        if (!savedRouting_) {
+            savedRouting_ = getdns_dict_create();
+        }
+        uint32_t value = 0;
+        getdns_list* upstreams = NULL;
+        if ((!setting || strcmp(setting, "resolution_type") == 0) &&
+            getdns_dict_get_int(all, "resolution_type", &value) == GETDNS_RETURN_GOOD) {
+            getdns_dict_set_int(savedRouting_, "resolution_type", value);
+        }
+        if ((!setting || strcmp(setting, "dns_transport") == 0) &&
+            getdns_dict_get_int(all, "dns_transport", &value) == GETDNS_RETURN_GOOD) {
+            getdns_dict_set_int(savedRouting_, "dns_transport", value);
+        }
+        if ((!setting || strcmp(setting, "upstream_recursive_servers") == 0) &&
+            getdns_dict_get_list(all, "upstream_recursive_servers", &upstreams) == GETDNS_RETURN_GOOD) {
+            getdns_dict_set_list(savedRouting_, "upstream_recursive_servers", upstreams);
+        }
+    }
+    getdns_dict_destroy(info);
+}
+
+// Put back the settings saved before replay started
+void GNContext::RestoreRouting() {
+    if (!savedRouting_) {
+        return;
+    }
+    uint32_t value = 0;
+    getdns_list* upstreams = NULL;
+    if (getdns_dict_get_int(savedRouting_, "resolution_type", &value) == GETDNS_RETURN_GOOD) {
+        getdns_context_set_resolution_type(context_, (getdns_resolution_t) value);
+    }
+    if (getdns_dict_get_int(savedRouting_, "dns_transport", &value) == GETDNS_RETURN_GOOD) {
+        getdns_context_set_dns_transport(context_, (getdns_transport_t) value);
+    }
+    if (getdns_dict_get_list(savedRouting_, "upstream_recursive_servers", &upstreams) == GETDNS_RETURN_GOOD) {
+        getdns_context_set_upstream_recursive_servers(context_, upstreams);
+    }
+    getdns_dict_destroy(savedRouting_);
+    savedRouting_ = NULL;
+}
+
+// Send every query to the replay server as a stub over UDP
+void GNContext::UseReplayServer() {
+    getdns_context_set_resolution_type(context_, GETDNS_RESOLUTION_STUB);
+    getdns_context_set_dns_transport(context_, GETDNS_TRANSPORT_UDP_ONLY);
+    getdns_list* upstreams = getdns_list_create();
+    getdns_dict* ipDict = getdns_util_create_ip("127.0.0.1");
+    getdns_dict_set_int(ipDict, "port", replay_->port());
+    getdns_list_set_dict(upstreams, 0, ipDict);
+    getdns_dict_destroy(ipDict);
+    getdns_context_set_upstream_recursive_servers(context_, upstreams);
+    getdns_list_destroy(upstreams);
+}
+
+void GNContext::ClearUpstreamStats() {
+    for (size_t i = 0; i < upstreamStats_.size(); ++i) {
+        delete upstreamStats_[i];
+    }
+    upstreamStats_.clear();
+    unattributedTimeouts_ = 0;
+}
+
+void GNContext::ConfigureUpstreamStats(Handle<Value> opt) {
+    if (!opt->IsArray()) {
+        return;
+    }
+    ClearUpstreamStats();
+    Handle<Array> values = Handle<Array>::Cast(opt);
+    for (uint32_t i = 0; i < values->Length(); ++i) {
+        Local<Value> ipOrTuple = values->Get(i);
+        Local<Value> ip = ipOrTuple;
+        uint32_t port = 0;
+        if (ipOrTuple->IsArray()) {
+            Handle<Array> tuple = Handle<Array>::Cast(ipOrTuple);
+            if (tuple->Length() == 0) {
+                continue;
+            }
+            ip = tuple->Get(0);
+            if (tuple->Length() > 1 && tuple->Get(1)->IsNumber()) {
+                port = tuple->Get(1)->Uint32Value();
+            }
+        }
+        NanUtf8String ipStr(ip->ToString());
+        GNUpstreamStats* upstream = new GNUpstreamStats();
+        upstream->addrLen = parseIp(*ipStr, upstream->addr);
+        if (upstream->addrLen == 0) {
+            // getdns setter reports the error
+            delete upstream;
+            continue;
+        }
+        upstream->address = *ipStr;
+        upstream->port = port;
+        upstreamStats_.push_back(upstream);
+    }
+}
+
+// Whether a reply answers the query in a call_debugging entry.  Only the
+// type is compared since the name may be a search list expansion.
+static bool sameQuestion(getdns_dict* entry, getdns_dict* reply) {
+    uint32_t queryType = 0;
+    uint32_t replyType = 0;
+    getdns_dict* question = NULL;
+    if (getdns_dict_get_int(entry, "query_type", &queryType) != GETDNS_RETURN_GOOD ||
+        getdns_dict_get_dict(reply, "question", &question) != GETDNS_RETURN_GOOD ||
+        getdns_dict_get_int(question, "qtype", &replyType) != GETDNS_RETURN_GOOD) {
+        // nothing to compare, trust the index
+        return true;
+    }
+    return queryType == replyType;
+}
+
+// Attribute each reply in the response to the upstream it came from
+void GNContext::RecordUpstreams(getdns_dict* response) {
+    getdns_list* debugging = NULL;
+    if (getdns_dict_get_list(response, "call_debugging", &debugging) != GETDNS_RETURN_GOOD) {
+        return;
+    }
+    size_t len = 0;
+    getdns_list_get_length(debugging, &len);
+    // Rcodes are taken from the reply at the same index, which is only
+    // the reply to that upstream query when every query got a reply.
+    getdns_list* replies = NULL;
+    size_t numReplies = 0;
+    if (getdns_dict_get_list(response, "replies_tree", &replies) != GETDNS_RETURN_GOOD ||
+        getdns_list_get_length(replies, &numReplies) != GETDNS_RETURN_GOOD ||
+        numReplies != len) {
+        replies = NULL;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        getdns_dict* entry = NULL;
+        getdns_dict* queryTo = NULL;
+        getdns_bindata* addr = NULL;
+        if (getdns_list_get_dict(debugging, i, &entry) != GETDNS_RETURN_GOOD ||
+            getdns_dict_get_dict(entry, "query_to", &queryTo) != GETDNS_RETURN_GOOD ||
+            getdns_dict_get_bindata(queryTo, "address_data", &addr) != GETDNS_RETURN_GOOD) {
+            continue;
+        }
+        uint32_t port = 0;
+        getdns_dict_get_int(queryTo, "port", &port);
+        // an exact port match wins over an address only match
+        GNUpstreamStats* upstream = NULL;
+        for (size_t u = 0; u < upstreamStats_.size(); ++u) {
+            GNUpstreamStats* candidate = upstreamStats_[u];
+            if (candidate->addrLen != addr->size ||
+                memcmp(candidate->addr, addr->data, addr->size) != 0) {
+                continue;
+            }
+            if (!upstream) {
+                upstream = candidate;
+            }
+            if (port != 0 && candidate->port == port) {
+                upstream = candidate;
+                break;
+            }
+        }
+        if (!upstream) {
+            continue;
+        }
+        ++upstream->responses;
+        uint32_t runTime = 0;
+        if (getdns_dict_get_int(entry, "run_time/ms", &runTime) == GETDNS_RETURN_GOOD) {
+            upstream->rtt.record(runTime);
+        }
+        getdns_dict* reply = NULL;
+        getdns_dict* header = NULL;
+        uint32_t rcode = 0;
+        if (replies &&
+            getdns_list_get_dict(replies, i, &reply) == GETDNS_RETURN_GOOD &&
+            sameQuestion(entry, reply) &&
+            getdns_dict_get_dict(reply, "header", &header) == GETDNS_RETURN_GOOD &&
+            getdns_dict_get_int(header, "rcode", &rcode) == GETDNS_RETURN_GOOD) {
+            ++upstream->rcodes[rcode & 0xF];
+        }
+    }
+}
+
+void GNContext::RecordConversion(CallbackData* data,
+                                 const GNConvertStats& convertStats,
+                                 uint64_t nanos) {
+    stats_.bytesConverted += convertStats.binaryBytes;
+    stats_.convertNodes += convertStats.nodes;
+    stats_.convertStrings += convertStats.strings;
+    stats_.convertBuffers += convertStats.buffers;
+    stats_.convertNanos.record(nanos);
+    if (stats_.slowConversions.wants(nanos)) {
+        stats_.slowConversions.offer(data->name.c_str(), data->type,
+                                     data->lookupType, nanos, convertStats);
+    }
+}
+
+// A timed out query has no response to tell which upstream was used.
+// It can only be attributed when there is a single upstream.
+void GNContext::RecordUpstreamTimeout() {
+    if (upstreamStats_.size() == 1) {
+        ++upstreamStats_[0]->timeouts;
+    } else {
+        ++unattributedTimeouts_;
+    }
+}
+
 NAN_GETTER(GNContext::GetContextValue) {
     // context has no getters yet
     NanScope();
@@ -246,6 +629,9 @@ NAN_SETTER(GNContext::SetContextValue) {
     if (!ctx) {
         NanThrowError("Context is invalid.");
     }
+    if (GNContext::SetBindingOption(ctx, *name, value)) {
+        return;
+    }
     size_t s = 0;
     bool found = false;
     for (s = 0; s < NUM_SETTERS && !found; ++s) {
@@ -255,6 +641,13 @@ NAN_SETTER(GNContext::SetContextValue) {
             break;
         }
     }
+    const char* setting = found && ctx->replay_ ? routingSetting(*name) : NULL;
+    if (setting) {
+        // replay keeps every query on the replay server, the new value
+        // applies once it is turned off
+        ctx->SaveRouting(setting);
+        ctx->UseReplayServer();
+    }
     if (!value->IsNumber()) {
         return;
     }
@@ -289,12 +682,30 @@ void GNContext::InitProperties(Handle<Object> ctx) {
             GNContext::GetContextValue, GNContext::SetContextValue);
 
     }
+    for (s = 0; s < NUM_BINDING_OPTIONS; ++s) {
+        ctx->SetAccessor(NanNew<String>(BINDING_OPTIONS[s]),
+            GNContext::GetContextValue, GNContext::SetContextValue);
+    }
 }
 
-GNContext::GNContext() : context_(NULL) { }
+GNContext::GNContext() : context_(NULL), scheduledInFlight_(0), nextId_(0),
+    stats_(), upstreamStatsEnabled_(false), unattributedTimeouts_(0),
+    replay_(NULL), savedRouting_(NULL) {
+    ++liveContexts_;
+}
 GNContext::~GNContext() {
+    --liveContexts_;
+    ClearUpstreamStats();
+    recorder_.close();
+    if (replay_) {
+        replay_->close();
+    }
+    if (savedRouting_) {
+        getdns_dict_destroy(savedRouting_);
+    }
     getdns_context_destroy(context_);
     context_ = NULL;
+    allocator_.release();
 }
 
 void GNContext::ApplyOptions(Handle<Object> self, Handle<Value> optsV) {
@@ -304,9 +715,15 @@ void GNContext::ApplyOptions(Handle<Object> self, Handle<Value> optsV) {
     TryCatch try_catch;
     Local<Object> opts = optsV->ToObject();
     Local<Array> names = opts->GetOwnPropertyNames();
-    // walk properties
+    Local<String> replayName = NanNew<String>("replay");
+    bool hasReplay = false;
+    // walk properties, replay last since it overrides the routing ones
     for(unsigned int i = 0; i < names->Length(); i++) {
         Local<Value> nameVal = names->Get(i);
+        if (nameVal->StrictEquals(replayName)) {
+            hasReplay = true;
+            continue;
+        }
         Local<Value> opt = opts->Get(nameVal);
         self->Set(nameVal, opt);
         if (try_catch.HasCaught()) {
@@ -314,6 +731,13 @@ void GNContext::ApplyOptions(Handle<Object> self, Handle<Value> optsV) {
             return;
         }
     }
+    if (hasReplay) {
+        self->Set(replayName, opts->Get(replayName));
+        if (try_catch.HasCaught()) {
+            try_catch.ReThrow();
+            return;
+        }
+    }
 }
 
 // Module initialization
@@ -326,16 +750,25 @@ void GNContext::Init(Handle<Object> target) {
     NODE_SET_PROTOTYPE_METHOD(jsContextTpl, "lookup", GNContext::Lookup);
     NODE_SET_PROTOTYPE_METHOD(jsContextTpl, "cancel", GNContext::Cancel);
     NODE_SET_PROTOTYPE_METHOD(jsContextTpl, "destroy", GNContext::Destroy);
-    // Helpers - delegate to the same function w/ different data
+    NODE_SET_PROTOTYPE_METHOD(jsContextTpl, "stats", GNContext::Stats);
+    NODE_SET_PROTOTYPE_METHOD(jsContextTpl, "traceEvents", GNContext::TraceEvents);
+    NODE_SET_PROTOTYPE_METHOD(jsContextTpl, "resolveStream", GNContext::ResolveStream);
+    // process for finding the active domain
+    NanAssignPersistent(process_,
+        NanGetCurrentContext()->Global()->Get(NanNew<String>("process"))->ToObject());
+    // Helpers - delegate to the same function w/ different data.  Set as
+    // templates so the functions are only made with the prototype.
     jsContextTpl->PrototypeTemplate()->Set(NanNew<String>("getAddress"),
-        NanNew<FunctionTemplate>(GNContext::HelperLookup, NanNew<Integer>(GNAddress))->GetFunction());
+        NanNew<FunctionTemplate>(GNContext::HelperLookup, NanNew<Integer>(GNAddress)));
     jsContextTpl->PrototypeTemplate()->Set(NanNew<String>("getHostname"),
-        NanNew<FunctionTemplate>(GNContext::HelperLookup, NanNew<Integer>(GNHostname))->GetFunction());
+        NanNew<FunctionTemplate>(GNContext::HelperLookup, NanNew<Integer>(GNHostname)));
     jsContextTpl->PrototypeTemplate()->Set(NanNew<String>("getService"),
-        NanNew<FunctionTemplate>(GNContext::HelperLookup, NanNew<Integer>(GNService))->GetFunction());
+        NanNew<FunctionTemplate>(GNContext::HelperLookup, NanNew<Integer>(GNService)));
 
     // Add the constructor
     target->Set(NanNew<String>("Context"), jsContextTpl->GetFunction());
+    target->Set(NanNew<String>("nativeStats"),
+        NanNew<FunctionTemplate>(GNContext::NativeStats)->GetFunction());
 
     // Export constants
     GNConstants::Init(target);
@@ -348,18 +781,136 @@ NAN_METHOD(GNContext::Destroy) {
     if (!ctx) {
         NanThrowError(NanNew<String>("Context is invalid."));
     }
+    ctx->CancelQueued();
     getdns_context_destroy(ctx->context_);
     ctx->context_ = NULL;
+    ctx->allocator_.release();
+    ctx->recorder_.close();
+    if (ctx->replay_) {
+        ctx->replay_->close();
+        ctx->replay_ = NULL;
+    }
+    if (ctx->savedRouting_) {
+        getdns_dict_destroy(ctx->savedRouting_);
+        ctx->savedRouting_ = NULL;
+    }
     NanReturnValue(NanTrue());
 }
 
+uint64_t GNContext::liveContexts_ = 0;
+uint64_t GNContext::liveQueries_ = 0;
+
+// Counters shared by all contexts: live objects and the libuv event
+// loop adapter
+NAN_METHOD(GNContext::NativeStats) {
+    NanScope();
+    Local<Object> live = NanNew<Object>();
+    live->Set(NanNew<String>("contexts"), NanNew<Number>((double) liveContexts_));
+    live->Set(NanNew<String>("queries"), NanNew<Number>((double) liveQueries_));
+    const GNLibuvStats& stats = gn_libuv_stats();
+    Local<Object> adapter = NanNew<Object>();
+    adapter->Set(NanNew<String>("schedules"), NanNew<Number>((double) stats.schedules));
+    adapter->Set(NanNew<String>("clears"), NanNew<Number>((double) stats.clears));
+    adapter->Set(NanNew<String>("live_events"), NanNew<Number>((double) stats.live));
+    adapter->Set(NanNew<String>("poll_starts"), NanNew<Number>((double) stats.pollStarts));
+    adapter->Set(NanNew<String>("poll_stops"), NanNew<Number>((double) stats.pollStops));
+    adapter->Set(NanNew<String>("timer_starts"), NanNew<Number>((double) stats.timerStarts));
+    Local<Object> result = NanNew<Object>();
+    result->Set(NanNew<String>("live"), live);
+    result->Set(NanNew<String>("event_loop"), adapter);
+    NanReturnValue(result);
+}
+
+// Snapshot of the context counters
+NAN_METHOD(GNContext::Stats) {
+    NanScope();
+    GNContext* ctx = ObjectWrap::Unwrap<GNContext>(args.This());
+    if (!ctx) {
+        NanThrowError(NanNew<String>("Context is invalid."));
+    }
+    const GNStats& stats = ctx->stats_;
+    Local<Object> result = NanNew<Object>();
+    result->Set(NanNew<String>("issued"), NanNew<Number>((double) stats.issued));
+    result->Set(NanNew<String>("completed"), NanNew<Number>((double) stats.completed));
+    result->Set(NanNew<String>("timed_out"), NanNew<Number>((double) stats.timedOut));
+    result->Set(NanNew<String>("cancelled"), NanNew<Number>((double) stats.cancelled));
+    result->Set(NanNew<String>("errored"), NanNew<Number>((double) stats.errored));
+    result->Set(NanNew<String>("in_flight"), NanNew<Number>((double) stats.inFlight));
+    result->Set(NanNew<String>("queued"), NanNew<Number>((double) ctx->scheduler_.size()));
+    result->Set(NanNew<String>("bytes_converted"), NanNew<Number>((double) stats.bytesConverted));
+    // latency in millis
+    result->Set(NanNew<String>("latency"), stats.latency.toJSObj(1000));
+    Local<Object> memory = NanNew<Object>();
+    memory->Set(NanNew<String>("bytes_in_use"), NanNew<Number>((double) ctx->allocator_.bytesInUse()));
+    memory->Set(NanNew<String>("allocations"), NanNew<Number>((double) ctx->allocator_.allocations()));
+    memory->Set(NanNew<String>("bytes_held"), NanNew<Number>((double) ctx->allocator_.bytesHeld()));
+    memory->Set(NanNew<String>("pool_bytes"), NanNew<Number>((double) ctx->allocator_.poolBytes()));
+    memory->Set(NanNew<String>("bytes_reported"), NanNew<Number>((double) ctx->allocator_.bytesReported()));
+    result->Set(NanNew<String>("memory"), memory);
+    // conversion times in micros
+    Local<Object> conversion = NanNew<Object>();
+    conversion->Set(NanNew<String>("time"), stats.convertNanos.toJSObj(1000));
+    conversion->Set(NanNew<String>("nodes"), NanNew<Number>((double) stats.convertNodes));
+    conversion->Set(NanNew<String>("strings"), NanNew<Number>((double) stats.convertStrings));
+    conversion->Set(NanNew<String>("buffers"), NanNew<Number>((double) stats.convertBuffers));
+    conversion->Set(NanNew<String>("binary_bytes"), NanNew<Number>((double) stats.bytesConverted));
+    conversion->Set(NanNew<String>("slowest"), stats.slowConversions.toJSArray());
+    result->Set(NanNew<String>("conversion"), conversion);
+    if (ctx->recorder_.recording()) {
+        result->Set(NanNew<String>("recorded"), NanNew<Number>((double) ctx->recorder_.records()));
+    }
+    if (ctx->replay_) {
+        Local<Object> replay = NanNew<Object>();
+        replay->Set(NanNew<String>("answered"), NanNew<Number>((double) ctx->replay_->answered()));
+        replay->Set(NanNew<String>("misses"), NanNew<Number>((double) ctx->replay_->misses()));
+        result->Set(NanNew<String>("replay"), replay);
+    }
+    if (ctx->upstreamStatsEnabled_) {
+        Local<Array> upstreams = NanNew<Array>();
+        for (size_t i = 0; i < ctx->upstreamStats_.size(); ++i) {
+            const GNUpstreamStats* upstream = ctx->upstreamStats_[i];
+            Local<Object> obj = NanNew<Object>();
+            obj->Set(NanNew<String>("address"), NanNew<String>(upstream->address.c_str()));
+            if (upstream->port) {
+                obj->Set(NanNew<String>("port"), NanNew<Integer>(upstream->port));
+            }
+            obj->Set(NanNew<String>("responses"), NanNew<Number>((double) upstream->responses));
+            obj->Set(NanNew<String>("timeouts"), NanNew<Number>((double) upstream->timeouts));
+            Local<Array> rcodes = NanNew<Array>();
+            for (uint32_t r = 0; r < 16; ++r) {
+                rcodes->Set(r, NanNew<Number>((double) upstream->rcodes[r]));
+            }
+            obj->Set(NanNew<String>("rcodes"), rcodes);
+            obj->Set(NanNew<String>("rtt"), upstream->rtt.toJSObj(1));
+            upstreams->Set(i, obj);
+        }
+        result->Set(NanNew<String>("upstreams"), upstreams);
+        result->Set(NanNew<String>("unattributed_timeouts"),
+                    NanNew<Number>((double) ctx->unattributedTimeouts_));
+    }
+    NanReturnValue(result);
+}
+
+// Drain the lifecycle trace as Chrome trace events
+NAN_METHOD(GNContext::TraceEvents) {
+    NanScope();
+    GNContext* ctx = ObjectWrap::Unwrap<GNContext>(args.This());
+    if (!ctx) {
+        NanThrowError(NanNew<String>("Context is invalid."));
+    }
+    NanReturnValue(ctx->trace_.drain());
+}
+
 // Create a context (new op)
 NAN_METHOD(GNContext::New) {
     NanScope();
     if (args.IsConstructCall()) {
         // new obj
         GNContext* ctx = new GNContext();
-        getdns_return_t r = getdns_context_create(&ctx->context_, 1);
+        // route getdns allocations through the counting allocator
+        getdns_return_t r = getdns_context_create_with_extended_memory_functions(
+            &ctx->context_, 1, &ctx->allocator_,
+            GNAllocator::Malloc, GNAllocator::Realloc, GNAllocator::Free);
         if (r != GETDNS_RETURN_GOOD) {
             // Failed to create an underlying context
             delete ctx;
@@ -396,33 +947,439 @@ NAN_METHOD(GNContext::New) {
     NanReturnUndefined();
 }
 
+// Count how a query ended
+static void countOutcome(GNStats& stats, getdns_callback_type_t outcome) {
+    switch (outcome) {
+        case GETDNS_CALLBACK_COMPLETE:
+            ++stats.completed;
+            break;
+        case GETDNS_CALLBACK_CANCEL:
+            ++stats.cancelled;
+            break;
+        case GETDNS_CALLBACK_TIMEOUT:
+            ++stats.timedOut;
+            break;
+        default:
+            ++stats.errored;
+            break;
+    }
+}
+
 void GNContext::Callback(getdns_context *context,
                          getdns_callback_type_t cbType,
                          getdns_dict *response,
                          void *userArg,
                          getdns_transaction_t transId) {
     CallbackData* data = static_cast<CallbackData*>(userArg);
+    GNContext* ctx = data->ctx;
+    // not known to the issuer yet if getdns calls back from within the call
+    data->transId = transId;
+    if (data->scheduled) {
+        ctx->scheduled_.erase(data->id);
+        --ctx->scheduledInFlight_;
+    } else {
+        data->id = transId;
+    }
+    --ctx->stats_.inFlight;
+    countOutcome(ctx->stats_, data->timedOut ? GETDNS_CALLBACK_TIMEOUT : cbType);
+    uint64_t now = uv_hrtime();
+    GN_PROBE_QUERY_DONE(data->id, cbType, now - data->issueTime);
+    if (cbType != GETDNS_CALLBACK_CANCEL || data->timedOut) {
+        ctx->stats_.latency.record((now - data->issueTime) / 1000);
+    }
+    if (ctx->trace_.enabled()) {
+        ctx->trace_.record(data->id, GNTraceResponse, now);
+    }
+    if (ctx->upstreamStatsEnabled_) {
+        if (cbType == GETDNS_CALLBACK_COMPLETE) {
+            ctx->RecordUpstreams(response);
+        } else if (cbType == GETDNS_CALLBACK_TIMEOUT) {
+            ctx->RecordUpstreamTimeout();
+        }
+    }
+    if (cbType == GETDNS_CALLBACK_COMPLETE && ctx->recorder_.recording()) {
+        ctx->recorder_.record(response, (now - data->issueTime) / 1000);
+    }
     // Setup the callback arguments
     Handle<Value> argv[3];
     if (cbType == GETDNS_CALLBACK_COMPLETE) {
+        GNConvertStats convertStats = { 0, 0, 0, 0 };
+        GN_PROBE_CONVERT_START(data->id);
+        uint64_t convertStart = uv_hrtime();
         argv[0] = NanNull();
-        argv[1] = GNUtil::convertToJSObj(response);
+        argv[1] = GNUtil::convertToJSObj(response, &convertStats);
         getdns_dict_destroy(response);
+        uint64_t convertEnd = uv_hrtime();
+        GN_PROBE_CONVERT_END(data->id, convertEnd - convertStart,
+                             convertStats.nodes, convertStats.binaryBytes);
+        ctx->RecordConversion(data, convertStats, convertEnd - convertStart);
+        if (ctx->trace_.enabled()) {
+            ctx->trace_.record(data->id, GNTraceConvertStart, convertStart);
+            ctx->trace_.record(data->id, GNTraceConvertEnd, convertEnd);
+        }
+    } else if (data->timedOut) {
+        // cancelled by the deadline timer
+        argv[0] = makeTimeoutErrorObj(data);
+        argv[1] = NanNull();
     } else {
         argv[0] = makeErrorObj("Lookup failed.", cbType);
         argv[1] = NanNull();
     }
-    TryCatch try_catch;
-    argv[2] = GNUtil::convertToBuffer(&transId, 8);
-    data->callback->Call(NanGetCurrentContext()->Global(), 3, argv);
+    argv[2] = GNUtil::convertToBuffer(&data->id, 8);
+    InvokeCallback(data, 3, argv);
 
-    if (try_catch.HasCaught())
-        node::FatalException(try_catch);
+    bool scheduled = data->scheduled;
+    if (data->inIssue) {
+        // Issue is still using it
+        data->finished = true;
+    } else {
+        FreeCallbackData(data);
+    }
+    if (scheduled) {
+        ctx->Pump();
+    }
+    // a destroyed context has given back all it reported
+    if (ctx->context_) {
+        ctx->allocator_.report();
+    }
+}
+
+// native memory held by a query outside getdns
+static int64_t callbackDataSize(CallbackData* data) {
+    return sizeof(CallbackData) + sizeof(NanCallback) +
+           data->name.capacity() + data->tenant.capacity();
+}
 
-    // Unref
+static void closeDeadline(uv_handle_t* handle) {
+    free(handle);
+}
+
+void GNContext::FreeCallbackData(CallbackData* data) {
+    if (data->deadline) {
+        uv_timer_stop(data->deadline);
+        uv_close((uv_handle_t*) data->deadline, closeDeadline);
+    }
+    if (data->hasSignal) {
+        UnwatchSignal(data);
+    }
+    if (data->hasDomain) {
+        NanDisposePersistent(data->domain);
+    }
+    data->ctx->allocator_.track(-callbackDataSize(data));
     data->ctx->Unref();
+    if (data->extension) {
+        getdns_dict_destroy(data->extension);
+    }
     delete data->callback;
     delete data;
+    --liveQueries_;
+}
+
+Persistent<Object> GNContext::process_;
+
+void GNContext::InvokeCallback(CallbackData* data, int argc, Handle<Value> argv[]) {
+    GNTraceRing& trace = data->ctx->trace_;
+    if (trace.enabled()) {
+        trace.record(data->id, GNTraceCallbackStart, uv_hrtime());
+    }
+    TryCatch try_catch;
+    if (data->hasDomain) {
+        // MakeCallback enters the domain of the receiver
+        Local<Object> recv = NanNew<Object>();
+        recv->Set(NanNew<String>("domain"), NanNew(data->domain));
+        NanMakeCallback(recv, data->callback->GetFunction(), argc, argv);
+    } else {
+        data->callback->Call(NanGetCurrentContext()->Global(), argc, argv);
+    }
+    if (try_catch.HasCaught())
+        node::FatalException(try_catch);
+    if (trace.enabled()) {
+        uint64_t now = uv_hrtime();
+        trace.record(data->id, GNTraceCallbackEnd, now);
+        trace.record(data->id, GNTraceDone, now);
+    }
+}
+
+// Report a failure for a query that getdns never called back for
+void GNContext::FailQuery(CallbackData* data, Handle<Value> err,
+                          getdns_callback_type_t outcome) {
+    countOutcome(data->ctx->stats_, outcome);
+    Handle<Value> cbArgs[] = { err };
+    InvokeCallback(data, 1, cbArgs);
+    FreeCallbackData(data);
+}
+
+// Hand a query to getdns.  getdns may call back before returning, in
+// which case data->finished is set and the caller frees data once done
+// with it.
+getdns_return_t GNContext::Issue(CallbackData* data) {
+    GNContext* ctx = data->ctx;
+    const char* name = data->name.c_str();
+    // counted before the call for a callback from within it
+    data->issueTime = uv_hrtime();
+    data->issued = true;
+    data->inIssue = true;
+    ++ctx->stats_.issued;
+    ++ctx->stats_.inFlight;
+    getdns_transaction_t transId = 0;
+    getdns_return_t r = GETDNS_RETURN_GOOD;
+    if (data->lookupType == GNGeneral) {
+        r = getdns_general(ctx->context_, name, data->type, data->extension,
+                           data, &transId, GNContext::Callback);
+    } else if (data->lookupType == GNAddress) {
+        r = getdns_address(ctx->context_, name, data->extension,
+                           data, &transId, GNContext::Callback);
+    } else if (data->lookupType == GNService) {
+        r = getdns_service(ctx->context_, name, data->extension,
+                           data, &transId, GNContext::Callback);
+    } else {
+        // hostname
+        // convert to a dictionary..
+        getdns_dict* ip = getdns_util_create_ip(name);
+        if (ip) {
+            r = getdns_hostname(ctx->context_, ip, data->extension,
+                                data, &transId, GNContext::Callback);
+            getdns_dict_destroy(ip);
+        } else {
+            r = GETDNS_RETURN_GENERIC_ERROR;
+        }
+    }
+    data->inIssue = false;
+    if (data->finished) {
+        // the callback has reported the outcome
+        return GETDNS_RETURN_GOOD;
+    }
+    if (r != GETDNS_RETURN_GOOD) {
+        data->issued = false;
+        --ctx->stats_.issued;
+        --ctx->stats_.inFlight;
+        return r;
+    }
+    data->transId = transId;
+    return r;
+}
+
+void GNContext::StartDeadline(CallbackData* data) {
+    uv_timer_t* timer = (uv_timer_t*) malloc(sizeof(uv_timer_t));
+    if (!timer) {
+        return;
+    }
+    uv_timer_init(uv_default_loop(), timer);
+    timer->data = data;
+    uv_timer_start(timer, GNContext::DeadlineExpired, data->deadlineMs, 0);
+    data->deadline = timer;
+}
+
+#if UV_VERSION_MAJOR == 0
+void GNContext::DeadlineExpired(uv_timer_t* timer, int status)
+#else
+void GNContext::DeadlineExpired(uv_timer_t* timer)
+#endif
+{
+    NanScope();
+    CallbackData* data = static_cast<CallbackData*>(timer->data);
+    GNContext* ctx = data->ctx;
+    data->timedOut = true;
+    if (data->issued) {
+        // getdns calls back with a cancel which is reported as a timeout
+        getdns_cancel_callback(ctx->context_, data->transId);
+        return;
+    }
+    // still queued
+    ctx->scheduler_.remove(data);
+    ctx->scheduled_.erase(data->id);
+    FailQuery(data, makeTimeoutErrorObj(data), GETDNS_CALLBACK_TIMEOUT);
+}
+
+Persistent<Function> GNContext::abortListener_;
+std::multimap<int, CallbackData*> GNContext::abortRegistry_;
+
+// Register the query with its signal.  Returns false if the signal
+// has already been aborted.
+bool GNContext::WatchSignal(CallbackData* data) {
+    Local<Object> signal = NanNew(data->signal);
+    if (signal->Get(NanNew<String>("aborted"))->IsTrue()) {
+        return false;
+    }
+    // shared by every query, made on first use to keep it out of startup
+    if (abortListener_.IsEmpty()) {
+        NanAssignPersistent(abortListener_,
+            NanNew<FunctionTemplate>(GNContext::AbortListener)->GetFunction());
+    }
+    // EventTarget ignores a listener that is already registered, so
+    // this is only a real registration for the first query on a signal
+    Local<Value> add = signal->Get(NanNew<String>("addEventListener"));
+    if (add->IsFunction()) {
+        Handle<Value> addArgs[] = {
+            NanNew<String>("abort"), NanNew(abortListener_)
+        };
+        Local<Function>::Cast(add)->Call(signal, 2, addArgs);
+    }
+    abortRegistry_.insert(std::make_pair(signal->GetIdentityHash(), data));
+    return true;
+}
+
+void GNContext::UnwatchSignal(CallbackData* data) {
+    NanScope();
+    int hash = NanNew(data->signal)->GetIdentityHash();
+    std::pair<std::multimap<int, CallbackData*>::iterator,
+              std::multimap<int, CallbackData*>::iterator> range =
+        abortRegistry_.equal_range(hash);
+    for (std::multimap<int, CallbackData*>::iterator it = range.first;
+         it != range.second; ++it) {
+        if (it->second == data) {
+            abortRegistry_.erase(it);
+            break;
+        }
+    }
+    NanDisposePersistent(data->signal);
+    data->hasSignal = false;
+}
+
+// Called with the aborted signal as this
+NAN_METHOD(GNContext::AbortListener) {
+    NanScope();
+    Local<Object> signal = args.This();
+    int hash = signal->GetIdentityHash();
+    // Cancelling calls back into JS which may change the registry so
+    // look the next query up again after every cancel.
+    for (;;) {
+        CallbackData* found = NULL;
+        std::pair<std::multimap<int, CallbackData*>::iterator,
+                  std::multimap<int, CallbackData*>::iterator> range =
+            abortRegistry_.equal_range(hash);
+        for (std::multimap<int, CallbackData*>::iterator it = range.first;
+             it != range.second; ++it) {
+            CallbackData* data = it->second;
+            if (!data->aborted && NanNew(data->signal)->StrictEquals(signal)) {
+                found = data;
+                break;
+            }
+        }
+        if (!found) {
+            break;
+        }
+        found->aborted = true;
+        CancelQuery(found);
+    }
+    NanReturnUndefined();
+}
+
+bool GNContext::CancelQuery(CallbackData* data) {
+    GNContext* ctx = data->ctx;
+    GN_PROBE_QUERY_CANCEL(data->id);
+    if (!data->issued) {
+        // still queued - getdns has never seen it
+        ctx->scheduler_.remove(data);
+        ctx->scheduled_.erase(data->id);
+        FailQuery(data, makeErrorObj("Lookup failed.", GETDNS_CALLBACK_CANCEL),
+                  GETDNS_CALLBACK_CANCEL);
+        return true;
+    }
+    return getdns_cancel_callback(ctx->context_, data->transId) == GETDNS_RETURN_GOOD;
+}
+
+Handle<Value> GNContext::Submit(CallbackData* data) {
+    GNContext* ctx = data->ctx;
+    data->startTime = uv_hrtime();
+    ctx->allocator_.track(callbackDataSize(data));
+    ctx->allocator_.report();
+    Local<Value> domain = NanNew(process_)->Get(NanNew<String>("domain"));
+    if (domain->IsObject()) {
+        NanAssignPersistent(data->domain, domain->ToObject());
+        data->hasDomain = true;
+    }
+    if (ctx->upstreamStatsEnabled_) {
+        // needed to tell which upstream answered
+        if (!data->extension) {
+            data->extension = getdns_dict_create_with_context(ctx->context_);
+        }
+        getdns_dict_set_int(data->extension, "return_call_debugging",
+                            GETDNS_EXTENSION_TRUE);
+    }
+    if (data->hasSignal && !WatchSignal(data)) {
+        NanDisposePersistent(data->signal);
+        data->hasSignal = false;
+        FailQuery(data, makeErrorObj("Lookup failed.", GETDNS_CALLBACK_CANCEL),
+                  GETDNS_CALLBACK_CANCEL);
+        return NanUndefined();
+    }
+    if (data->deadlineMs > 0) {
+        StartDeadline(data);
+    }
+    if (!ctx->scheduler_.enabled()) {
+        getdns_return_t r = Issue(data);
+        if (r != GETDNS_RETURN_GOOD) {
+            FailQuery(data, makeErrorObj("Error issuing query", r),
+                  GETDNS_CALLBACK_ERROR);
+            return NanUndefined();
+        }
+        data->id = data->transId;
+        GN_PROBE_QUERY_SUBMIT(data->id, data->name.c_str(), data->type,
+                              data->lookupType);
+        if (ctx->trace_.enabled()) {
+            ctx->trace_.record(data->id, GNTraceSubmit, data->startTime,
+                               data->name.c_str(), data->type);
+            ctx->trace_.record(data->id, GNTraceIssue, data->issueTime);
+        }
+        // queries with a signal are cancelled through it, skip the id
+        Handle<Value> result = data->hasSignal ?
+            NanUndefined() : GNUtil::convertToBuffer(&data->id, 8);
+        if (data->finished) {
+            FreeCallbackData(data);
+        }
+        return result;
+    }
+    // scheduled queries get an id from the binding since the
+    // getdns transaction does not exist until it is issued
+    data->scheduled = true;
+    data->id = ++ctx->nextId_;
+    ctx->scheduled_[data->id] = data;
+    ctx->scheduler_.push(data);
+    GN_PROBE_QUERY_SUBMIT(data->id, data->name.c_str(), data->type,
+                          data->lookupType);
+    if (ctx->trace_.enabled()) {
+        ctx->trace_.record(data->id, GNTraceSubmit, data->startTime,
+                           data->name.c_str(), data->type);
+    }
+    Handle<Value> result = data->hasSignal ?
+        NanUndefined() : GNUtil::convertToBuffer(&data->id, 8);
+    ctx->Pump();
+    return result;
+}
+
+void GNContext::Pump() {
+    while (context_ && scheduler_.hasBudget(scheduledInFlight_)) {
+        CallbackData* data = scheduler_.pop();
+        if (!data) {
+            break;
+        }
+        // counted before the call for a callback from within it
+        ++scheduledInFlight_;
+        getdns_return_t r = Issue(data);
+        if (r != GETDNS_RETURN_GOOD) {
+            --scheduledInFlight_;
+            scheduled_.erase(data->id);
+            FailQuery(data, makeErrorObj("Error issuing query", r),
+                  GETDNS_CALLBACK_ERROR);
+            continue;
+        }
+        if (trace_.enabled()) {
+            trace_.record(data->id, GNTraceIssue, data->issueTime);
+        }
+        if (data->finished) {
+            FreeCallbackData(data);
+        }
+    }
+}
+
+void GNContext::CancelQueued() {
+    CallbackData* data = NULL;
+    while ((data = scheduler_.pop()) != NULL) {
+        scheduled_.erase(data->id);
+        FailQuery(data, makeErrorObj("Lookup failed.", GETDNS_CALLBACK_CANCEL),
+                  GETDNS_CALLBACK_CANCEL);
+    }
 }
 
 // Cancel a req.  Expect it to be a transaction id as a buffer
@@ -440,6 +1397,11 @@ NAN_METHOD(GNContext::Cancel) {
     }
     uint64_t transId;
     memcpy(&transId, node::Buffer::Data(args[0]), 8);
+    std::map<uint64_t, CallbackData*>::iterator it = ctx->scheduled_.find(transId);
+    if (it != ctx->scheduled_.end()) {
+        NanReturnValue(CancelQuery(it->second) ? NanTrue() : NanFalse());
+    }
+    GN_PROBE_QUERY_CANCEL(transId);
     getdns_return_t r = getdns_cancel_callback(ctx->context_, transId);
     NanReturnValue(r == GETDNS_RETURN_GOOD ? NanTrue() : NanFalse());
 }
@@ -475,36 +1437,26 @@ NAN_METHOD(GNContext::Lookup) {
     }
     uint16_t type = (uint16_t) args[1]->Uint32Value();
 
-    // optional third arg is an object
-    getdns_dict* extension = NULL;
-    if (args.Length() > 3 && args[2]->IsObject()) {
-        extension = GNUtil::convertToDict(args[2]->ToObject());
-    }
-
     // create callback data
     CallbackData *data = new CallbackData();
+    ++liveQueries_;
     data->callback = new NanCallback(localCb);
     data->ctx = ctx;
+    data->lookupType = GNGeneral;
+    data->name = *name;
+    data->type = type;
     ctx->Ref();
 
-    // issue a query
-    getdns_transaction_t transId;
-    getdns_return_t r = getdns_general(ctx->context_, *name, type,
-                                       extension, data, &transId,
-                                       GNContext::Callback);
-    if (r != GETDNS_RETURN_GOOD) {
-        // fail
-        delete data->callback;
-        data->ctx->Unref();
-        delete data;
-
-        Handle<Value> err = makeErrorObj("Error issuing query", r);
-        Handle<Value> cbArgs[] = { err };
-        localCb->Call(NanGetCurrentContext()->Global(), 1, cbArgs);
-        NanReturnUndefined();
+    // optional third arg is an object
+    if (args.Length() > 3 && args[2]->IsObject()) {
+        Local<Object> ext = args[2]->ToObject();
+        readBindingExtensions(ext, data);
+        data->extension = GNUtil::convertToDict(ext, BINDING_EXTENSIONS,
+                                                ctx->context_);
     }
-    // done.
-    NanReturnValue(GNUtil::convertToBuffer(&transId, 8));
+
+    // issue or queue the query
+    NanReturnValue(GNContext::Submit(data));
 }
 
 // Common function to handle getdns_address/service/hostname
@@ -533,56 +1485,82 @@ NAN_METHOD(GNContext::HelperLookup) {
     // take first arg and make it a string
     String::Utf8Value name(args[0]->ToString());
 
-    // 2nd arg could be extensions
-    // optional third arg is an object
-    getdns_dict* extension = NULL;
-    if (args.Length() > 2 && args[1]->IsObject()) {
-        extension = GNUtil::convertToDict(args[1]->ToObject());
-    }
-
     // figure out what called us
     uint32_t funcType = args.Data()->Uint32Value();
     // create callback data
     CallbackData *data = new CallbackData();
+    ++liveQueries_;
     data->callback = new NanCallback(localCb);
     data->ctx = ctx;
+    data->lookupType = (LookupType) funcType;
+    data->name = *name;
     ctx->Ref();
 
-    getdns_transaction_t transId;
-    getdns_return_t r = GETDNS_RETURN_GOOD;
-    if (funcType == GNAddress) {
-        r = getdns_address(ctx->context_, *name, extension,
-                           data, &transId, GNContext::Callback);
-    } else if(funcType == GNService) {
-        r = getdns_service(ctx->context_, *name, extension,
-                           data, &transId, GNContext::Callback);
-    } else {
-        // hostname
-        // convert to a dictionary..
-        getdns_dict* ip = getdns_util_create_ip(*name);
-        if (ip) {
-            r = getdns_hostname(ctx->context_, ip, extension,
-                                data, &transId, GNContext::Callback);
-            getdns_dict_destroy(ip);
-        } else {
-            r = GETDNS_RETURN_GENERIC_ERROR;
-        }
+    // 2nd arg could be extensions
+    if (args.Length() > 2 && args[1]->IsObject()) {
+        Local<Object> ext = args[1]->ToObject();
+        readBindingExtensions(ext, data);
+        data->extension = GNUtil::convertToDict(ext, BINDING_EXTENSIONS,
+                                                ctx->context_);
     }
 
-    if (r != GETDNS_RETURN_GOOD) {
-        // fail
-        delete data->callback;
-        data->ctx->Unref();
-        delete data;
+    // done. return as buffer
+    NanReturnValue(GNContext::Submit(data));
+}
 
-        Handle<Value> err = makeErrorObj("Error issuing query", r);
+// Resolve names read from a file descriptor, see GNStream.h
+// resolveStream(inFd, outFd, [opts], callback)
+// Stream queries go to getdns directly: max_in_flight, deadlines,
+// stats(), trace, record and upstream_stats do not see them.
+NAN_METHOD(GNContext::ResolveStream) {
+    NanScope();
+    if (args.Length() < 3) {
+        NanThrowTypeError("At least 3 arguments are required.");
+        NanReturnUndefined();
+    }
+    Local<Value> last = args[args.Length() - 1];
+    if (!last->IsFunction()) {
+        NanThrowTypeError("Final argument must be a function.");
+        NanReturnUndefined();
+    }
+    if (!args[0]->IsInt32() || !args[1]->IsInt32()) {
+        NanThrowTypeError("File descriptors must be integers.");
+        NanReturnUndefined();
+    }
+    Local<Function> localCb = Local<Function>::Cast(last);
+    GNContext* ctx = node::ObjectWrap::Unwrap<GNContext>(args.This());
+    if (!ctx || !ctx->context_) {
+        Handle<Value> err = makeErrorObj("Context is invalid", GETDNS_RETURN_GENERIC_ERROR);
         Handle<Value> cbArgs[] = { err };
-        localCb->Call(NanGetCurrentContext()->Global(), 1, cbArgs);
+        NanMakeCallback(NanGetCurrentContext()->Global(), localCb, 1, cbArgs);
         NanReturnUndefined();
     }
-    // done. return as buffer
-    NanReturnValue(GNUtil::convertToBuffer(&transId, 8));
+    // options: type (addresses when not given), concurrency and extensions
+    uint16_t type = 0;
+    uint32_t window = DEFAULT_STREAM_WINDOW;
+    getdns_dict* extension = NULL;
+    if (args.Length() > 3 && args[2]->IsObject()) {
+        Local<Object> opts = args[2]->ToObject();
+        Local<Value> typeVal = opts->Get(NanNew<String>("type"));
+        if (typeVal->IsNumber()) {
+            type = (uint16_t) typeVal->Uint32Value();
+        }
+        Local<Value> windowVal = opts->Get(NanNew<String>("concurrency"));
+        if (windowVal->IsNumber()) {
+            window = windowVal->Uint32Value();
+        }
+        Local<Value> ext = opts->Get(NanNew<String>("extensions"));
+        if (ext->IsObject()) {
+            extension = GNUtil::convertToDict(ext->ToObject(), BINDING_EXTENSIONS,
+                                              ctx->context_);
+        }
+    }
+    GNStream::start(ctx, args[0]->Int32Value(), args[1]->Int32Value(), type,
+                    extension, window, new NanCallback(localCb));
+    NanReturnUndefined();
 }
 
 // Init the module
+#ifndef GN_NO_MODULE
 NODE_MODULE(getdns, GNContext::Init)
+#endif
@@ -31,6 +31,15 @@
 #include <node.h>
 #include <nan.h>
 #include <getdns/getdns.h>
+#include <map>
+#include <vector>
+
+#include "GNCallbackData.h"
+#include "GNMemory.h"
+#include "GNReplay.h"
+#include "GNScheduler.h"
+#include "GNStats.h"
+#include "GNTrace.h"
 
 // Getdns Context wrapper for Node
 class GNContext : public node::ObjectWrap {
@@ -39,6 +48,9 @@ public:
     static void Init(v8::Handle<v8::Object> target);
 
 private:
+    // streams issue queries on the context directly
+    friend class GNStream;
+
     GNContext();
     ~GNContext();
 
@@ -46,12 +58,25 @@ private:
     static void ApplyOptions(v8::Handle<v8::Object> self,
                              v8::Handle<v8::Value> opts);
 
+    // set an option implemented by the binding rather than getdns
+    // returns false if name is not a binding option
+    static bool SetBindingOption(GNContext* ctx, const char* name,
+                                 v8::Handle<v8::Value> value);
+
     // JS Functions
     static NAN_METHOD(New);
     static NAN_METHOD(Destroy);
     static NAN_METHOD(Lookup);
     static NAN_METHOD(HelperLookup);
     static NAN_METHOD(Cancel);
+    static NAN_METHOD(Stats);
+    static NAN_METHOD(TraceEvents);
+    static NAN_METHOD(ResolveStream);
+    // module level, counters shared by all contexts
+    static NAN_METHOD(NativeStats);
+    // live objects across all contexts, for leak checks
+    static uint64_t liveContexts_;
+    static uint64_t liveQueries_;
 
     static void InitProperties(v8::Handle<v8::Object> self);
     static NAN_GETTER(GetContextValue);
@@ -64,9 +89,83 @@ private:
                          void *userArg,
                          getdns_transaction_t this_transaction_id);
 
+    // Query submission.  Submit either issues the query or hands it
+    // to the scheduler.  Returns the id for JS or undefined on failure.
+    static v8::Handle<v8::Value> Submit(CallbackData* data);
+    static getdns_return_t Issue(CallbackData* data);
+    static void FailQuery(CallbackData* data, v8::Handle<v8::Value> err,
+                          getdns_callback_type_t outcome);
+    static void FreeCallbackData(CallbackData* data);
+
+    // Call the JS callback in the domain the query was made in
+    static void InvokeCallback(CallbackData* data, int argc,
+                               v8::Handle<v8::Value> argv[]);
+    static v8::Persistent<v8::Object> process_;
+
+    // Per query deadlines
+    static void StartDeadline(CallbackData* data);
+#if UV_VERSION_MAJOR == 0
+    static void DeadlineExpired(uv_timer_t* timer, int status);
+#else
+    static void DeadlineExpired(uv_timer_t* timer);
+#endif
+
+    // Cancel a query, queued or issued.  Returns false if getdns
+    // does not know about it.
+    static bool CancelQuery(CallbackData* data);
+
+    // AbortSignal support.  One listener is shared by every query and
+    // finds the queries for a signal through its identity hash.
+    static bool WatchSignal(CallbackData* data);
+    static void UnwatchSignal(CallbackData* data);
+    static NAN_METHOD(AbortListener);
+    static v8::Persistent<v8::Function> abortListener_;
+    static std::multimap<int, CallbackData*> abortRegistry_;
+
+    // Issue queued queries while there is budget
+    void Pump();
+    // Fail every query still held by the scheduler
+    void CancelQueued();
+
+    // Counts the memory getdns allocates for this context
+    GNAllocator allocator_;
+
     // Underlying getdns_context
     struct getdns_context* context_;
 
+    // Scheduler state
+    GNScheduler scheduler_;
+    std::map<uint64_t, CallbackData*> scheduled_;
+    uint32_t scheduledInFlight_;
+    uint64_t nextId_;
+
+    // Counters
+    GNStats stats_;
+
+    // Per upstream counters
+    void ConfigureUpstreamStats(v8::Handle<v8::Value> upstreams);
+    void ClearUpstreamStats();
+    void RecordUpstreams(getdns_dict* response);
+    void RecordUpstreamTimeout();
+    void RecordConversion(CallbackData* data,
+                          const GNConvertStats& convertStats,
+                          uint64_t nanos);
+    bool upstreamStatsEnabled_;
+    std::vector<GNUpstreamStats*> upstreamStats_;
+    uint64_t unattributedTimeouts_;
+
+    // Query lifecycle trace
+    GNTraceRing trace_;
+
+    // Record and replay of upstream answers
+    void UseReplayServer();
+    void SaveRouting(const char* setting);
+    void RestoreRouting();
+    GNRecorder recorder_;
+    GNReplayServer* replay_;
+    // the routing replay overrides, restored when it is turned off
+    getdns_dict* savedRouting_;
+
 };
 
 #endif
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GNLibuv.h"
+#include "GNProbes.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// Mostly copied from getdns lib_uv extension but is long lived
+// until explicit free
+
+static GNLibuvStats stats = { 0, 0, 0, 0, 0, 0 };
+
+typedef struct getdns_libuv {
+    getdns_eventloop_vmt *vmt;
+    uv_loop_t            *loop;
+} getdns_libuv;
+
+static void
+getdns_libuv_run(getdns_eventloop *loop)
+{
+    (void) uv_run(((getdns_libuv *)loop)->loop, UV_RUN_DEFAULT);
+}
+
+static void
+getdns_libuv_run_once(getdns_eventloop *loop, int blocking)
+{
+    (void) uv_run(((getdns_libuv *)loop)->loop,
+        blocking ? UV_RUN_ONCE : UV_RUN_NOWAIT);
+}
+
+static void
+getdns_libuv_cleanup(getdns_eventloop *loop)
+{
+    getdns_libuv *ext = (getdns_libuv *)loop;
+    free(ext);
+}
+
+typedef struct poll_timer {
+    uv_poll_t        read;
+    uv_poll_t        write;
+    uv_timer_t       timer;
+    int              to_close;
+} poll_timer;
+
+static void
+getdns_libuv_close_cb(uv_handle_t *handle)
+{
+    poll_timer *my_ev = (poll_timer *)handle->data;
+
+    if (--my_ev->to_close) {
+        return;
+    }
+    --stats.live;
+    free(my_ev);
+}
+
+static getdns_return_t
+getdns_libuv_clear(getdns_eventloop *loop, getdns_eventloop_event *el_ev)
+{
+    poll_timer   *my_ev = (poll_timer *)el_ev->ev;
+    uv_poll_t    *my_poll;
+    uv_timer_t   *my_timer;
+
+    assert(my_ev);
+    GN_PROBE_EVENT_CLEAR(my_ev);
+    ++stats.clears;
+
+    if (el_ev->read_cb) {
+        my_poll = &my_ev->read;
+        uv_poll_stop(my_poll);
+        ++stats.pollStops;
+        my_ev->to_close += 1;
+        my_poll->data = my_ev;
+        uv_close((uv_handle_t *)my_poll, getdns_libuv_close_cb);
+    }
+    if (el_ev->write_cb) {
+        my_poll = &my_ev->write;
+        uv_poll_stop(my_poll);
+        ++stats.pollStops;
+        my_ev->to_close += 1;
+        my_poll->data = my_ev;
+        uv_close((uv_handle_t *)my_poll, getdns_libuv_close_cb);
+    }
+    if (el_ev->timeout_cb) {
+        my_timer = &my_ev->timer;
+        uv_timer_stop(my_timer);
+        my_ev->to_close += 1;
+        my_timer->data = my_ev;
+        uv_close((uv_handle_t *)my_timer, getdns_libuv_close_cb);
+    }
+    el_ev->ev = NULL;
+    return GETDNS_RETURN_GOOD;
+}
+
+static void
+getdns_libuv_read_cb(uv_poll_t *poll, int status, int events)
+{
+        getdns_eventloop_event *el_ev = (getdns_eventloop_event *)poll->data;
+        assert(el_ev->read_cb);
+        el_ev->read_cb(el_ev->userarg);
+}
+
+static void
+getdns_libuv_write_cb(uv_poll_t *poll, int status, int events)
+{
+        getdns_eventloop_event *el_ev = (getdns_eventloop_event *)poll->data;
+        assert(el_ev->write_cb);
+        el_ev->write_cb(el_ev->userarg);
+}
+
+static void
+#if UV_VERSION_MAJOR == 0
+getdns_libuv_timeout_cb(uv_timer_t *timer, int status)
+#else
+getdns_libuv_timeout_cb(uv_timer_t *timer)
+#endif
+{
+        getdns_eventloop_event *el_ev = (getdns_eventloop_event *)timer->data;
+        assert(el_ev->timeout_cb);
+        el_ev->timeout_cb(el_ev->userarg);
+}
+
+static getdns_return_t
+getdns_libuv_schedule(getdns_eventloop *loop,
+    int fd, uint64_t timeout, getdns_eventloop_event *el_ev)
+{
+    getdns_libuv *ext = (getdns_libuv *)loop;
+    poll_timer   *my_ev;
+    uv_poll_t    *my_poll;
+    uv_timer_t   *my_timer;
+
+    assert(el_ev);
+    assert(!(el_ev->read_cb || el_ev->write_cb) || fd >= 0);
+    assert(  el_ev->read_cb || el_ev->write_cb  || el_ev->timeout_cb);
+
+    my_ev = (poll_timer*)malloc(sizeof(poll_timer));
+    if (!my_ev)
+        return GETDNS_RETURN_MEMORY_ERROR;
+
+    my_ev->to_close = 0;
+    el_ev->ev = my_ev;
+    GN_PROBE_EVENT_SCHEDULE(my_ev, fd, timeout);
+    ++stats.schedules;
+    ++stats.live;
+
+    if (el_ev->read_cb) {
+        my_poll = &my_ev->read;
+        my_poll->data = el_ev;
+        uv_poll_init(ext->loop, my_poll, fd);
+        uv_poll_start(my_poll, UV_READABLE, getdns_libuv_read_cb);
+        ++stats.pollStarts;
+    }
+    if (el_ev->write_cb) {
+        my_poll = &my_ev->write;
+        my_poll->data = el_ev;
+        uv_poll_init(ext->loop, my_poll, fd);
+        uv_poll_start(my_poll, UV_WRITABLE, getdns_libuv_write_cb);
+        ++stats.pollStarts;
+    }
+    if (el_ev->timeout_cb) {
+        my_timer = &my_ev->timer;
+        my_timer->data = el_ev;
+        uv_timer_init(ext->loop, my_timer);
+        uv_timer_start(my_timer, getdns_libuv_timeout_cb, timeout, 0);
+        ++stats.timerStarts;
+    }
+    return GETDNS_RETURN_GOOD;
+}
+
+static getdns_eventloop_vmt getdns_libuv_vmt = {
+    getdns_libuv_cleanup,
+    getdns_libuv_schedule,
+    getdns_libuv_clear,
+    getdns_libuv_run,
+    getdns_libuv_run_once
+};
+
+getdns_eventloop*
+gn_libuv_create(uv_loop_t *loop)
+{
+    getdns_libuv *ext;
+
+    if (!loop)
+        return NULL;
+
+    ext = (getdns_libuv*)malloc(sizeof(getdns_libuv));
+    if (!ext)
+        return NULL;
+    ext->vmt  = &getdns_libuv_vmt;
+    ext->loop = loop;
+    return (getdns_eventloop *)ext;
+}
+
+getdns_return_t
+getdns_extension_set_libuv_loop(getdns_context *context, uv_loop_t *loop)
+{
+    getdns_eventloop *ext;
+
+    if (!context)
+        return GETDNS_RETURN_BAD_CONTEXT;
+    if (!loop)
+        return GETDNS_RETURN_INVALID_PARAMETER;
+
+    ext = gn_libuv_create(loop);
+    if (!ext)
+        return GETDNS_RETURN_MEMORY_ERROR;
+
+    return getdns_context_set_eventloop(context, ext);
+}
+
+const GNLibuvStats&
+gn_libuv_stats()
+{
+    return stats;
+}
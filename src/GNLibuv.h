@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_LIBUV_H_
+#define _GN_LIBUV_H_
+
+#include <getdns/getdns.h>
+#include <getdns/getdns_extra.h>
+#include <uv.h>
+
+// Counters kept by the libuv event loop adapter across all contexts
+typedef struct GNLibuvStats {
+    uint64_t schedules;
+    uint64_t clears;
+    // events scheduled whose handles are not closed yet
+    uint64_t live;
+    // each start and stop of a poll handle costs libuv about one
+    // epoll_ctl (or kevent) call
+    uint64_t pollStarts;
+    uint64_t pollStops;
+    uint64_t timerStarts;
+} GNLibuvStats;
+
+// Run the queries of context on loop
+getdns_return_t getdns_extension_set_libuv_loop(getdns_context *context,
+                                                uv_loop_t *loop);
+
+// The adapter on its own, to drive it without a context.  Free it with
+// the cleanup function of its vmt.
+getdns_eventloop* gn_libuv_create(uv_loop_t *loop);
+
+const GNLibuvStats& gn_libuv_stats();
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GNMemory.h"
+
+#include <nan.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Every block starts with a header that keeps the payload aligned like
+// malloc's and records how the block was allocated
+typedef struct BlockHeader {
+    size_t size;
+    // size class or NO_CLASS for malloc
+    int cls;
+} BlockHeader;
+
+static const size_t HEADER_SIZE = 16;
+static const int NO_CLASS = -1;
+
+static const size_t SIZE_CLASSES[GNAllocator::NUM_CLASSES] = {
+    32, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+// each slab holds blocks of a single class
+static const size_t SLAB_SIZE = 64 * 1024;
+
+// smallest change in memory held worth telling V8 about
+static const int64_t REPORT_THRESHOLD = 64 * 1024;
+
+static int sizeClass(size_t size) {
+    for (int i = 0; i < GNAllocator::NUM_CLASSES; ++i) {
+        if (size <= SIZE_CLASSES[i]) {
+            return i;
+        }
+    }
+    return NO_CLASS;
+}
+
+GNAllocator::GNAllocator() : pooling_(false), inUse_(0), held_(0),
+    poolBytes_(0), reported_(0), allocations_(0), totalAllocations_(0) {
+    memset(freeLists_, 0, sizeof(freeLists_));
+}
+
+GNAllocator::~GNAllocator() {
+    for (size_t i = 0; i < slabs_.size(); ++i) {
+        free(slabs_[i]);
+    }
+}
+
+// Carve a new slab into free blocks of the class
+bool GNAllocator::grow(int cls) {
+    size_t blockSize = HEADER_SIZE + SIZE_CLASSES[cls];
+    char* slab = (char*) malloc(SLAB_SIZE);
+    if (!slab) {
+        return false;
+    }
+    slabs_.push_back(slab);
+    poolBytes_ += SLAB_SIZE;
+    held_ += SLAB_SIZE;
+    for (size_t off = 0; off + blockSize <= SLAB_SIZE; off += blockSize) {
+        char* block = slab + off;
+        ((BlockHeader*) block)->cls = cls;
+        *(void**) (block + HEADER_SIZE) = freeLists_[cls];
+        freeLists_[cls] = block + HEADER_SIZE;
+    }
+    return true;
+}
+
+void* GNAllocator::allocate(size_t size) {
+    int cls = pooling_ ? sizeClass(size) : NO_CLASS;
+    char* block = NULL;
+    if (cls != NO_CLASS) {
+        if (!freeLists_[cls] && !grow(cls)) {
+            return NULL;
+        }
+        char* payload = (char*) freeLists_[cls];
+        freeLists_[cls] = *(void**) payload;
+        block = payload - HEADER_SIZE;
+    } else {
+        block = (char*) malloc(size + HEADER_SIZE);
+        if (!block) {
+            return NULL;
+        }
+        held_ += size;
+    }
+    BlockHeader* header = (BlockHeader*) block;
+    header->size = size;
+    header->cls = cls;
+    inUse_ += size;
+    ++allocations_;
+    ++totalAllocations_;
+    return block + HEADER_SIZE;
+}
+
+void GNAllocator::freeBlock(char* block) {
+    BlockHeader* header = (BlockHeader*) block;
+    inUse_ -= header->size;
+    --allocations_;
+    if (header->cls == NO_CLASS) {
+        held_ -= header->size;
+        free(block);
+        return;
+    }
+    *(void**) (block + HEADER_SIZE) = freeLists_[header->cls];
+    freeLists_[header->cls] = block + HEADER_SIZE;
+}
+
+void* GNAllocator::Malloc(void* userarg, size_t size) {
+    return static_cast<GNAllocator*>(userarg)->allocate(size);
+}
+
+void* GNAllocator::Realloc(void* userarg, void* ptr, size_t size) {
+    GNAllocator* self = static_cast<GNAllocator*>(userarg);
+    if (!ptr) {
+        return self->allocate(size);
+    }
+    char* block = (char*) ptr - HEADER_SIZE;
+    BlockHeader* header = (BlockHeader*) block;
+    size_t oldSize = header->size;
+    if (header->cls != NO_CLASS && size <= SIZE_CLASSES[header->cls]) {
+        // still fits the block
+        header->size = size;
+        self->inUse_ += (int64_t) size - (int64_t) oldSize;
+        return ptr;
+    }
+    if (header->cls == NO_CLASS && sizeClass(size) == NO_CLASS) {
+        block = (char*) realloc(block, size + HEADER_SIZE);
+        if (!block) {
+            return NULL;
+        }
+        header = (BlockHeader*) block;
+        header->size = size;
+        self->inUse_ += (int64_t) size - (int64_t) oldSize;
+        self->held_ += (int64_t) size - (int64_t) oldSize;
+        return block + HEADER_SIZE;
+    }
+    // moving between the pool and malloc
+    void* result = self->allocate(size);
+    if (!result) {
+        return NULL;
+    }
+    memcpy(result, ptr, oldSize < size ? oldSize : size);
+    self->freeBlock(block);
+    return result;
+}
+
+void GNAllocator::Free(void* userarg, void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    static_cast<GNAllocator*>(userarg)->freeBlock((char*) ptr - HEADER_SIZE);
+}
+
+void GNAllocator::report() {
+    int64_t delta = held_ - reported_;
+    if (delta >= REPORT_THRESHOLD || delta <= -REPORT_THRESHOLD) {
+        NanAdjustExternalMemory((int) delta);
+        reported_ += delta;
+    }
+}
+
+void GNAllocator::release() {
+    if (reported_ != 0) {
+        NanAdjustExternalMemory((int) -reported_);
+        reported_ = 0;
+    }
+}
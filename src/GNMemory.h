@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_MEMORY_H_
+#define _GN_MEMORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Counting allocator handed to getdns as the context memory functions
+// so the native memory held by a context is known and can be reported
+// to V8.  Each allocation carries a small header with its size.
+//
+// When pooling is on, small allocations come from per size class free
+// lists carved out of slabs instead of malloc.  getdns makes many small,
+// short lived allocations per query (dicts, lists, bindatas) and this
+// keeps them from fragmenting the malloc heap of a long lived process.
+// Slabs are kept until the allocator is destroyed with the context.
+//
+// getdns calls these from the thread running the event loop, the same
+// one that runs JS, so nothing here is locked or atomic.
+class GNAllocator {
+public:
+    GNAllocator();
+    ~GNAllocator();
+
+    // getdns extended memory functions - userarg is the GNAllocator
+    static void* Malloc(void* userarg, size_t size);
+    static void* Realloc(void* userarg, void* ptr, size_t size);
+    static void Free(void* userarg, void* ptr);
+
+    // Pool small allocations.  Can be changed at any time, blocks are
+    // freed the way they were allocated.
+    void setPooling(bool pooling) { pooling_ = pooling; }
+    bool pooling() const { return pooling_; }
+
+    // account for native memory allocated outside getdns
+    void track(int64_t bytes) { inUse_ += bytes; held_ += bytes; }
+
+    // Tell V8 about the change in memory held since the last report
+    // once it is large enough to matter.  Must be called from the JS
+    // thread.
+    void report();
+    // Give back everything reported so far
+    void release();
+
+    // bytes requested and not yet freed
+    int64_t bytesInUse() const { return inUse_; }
+    // bytes held from the system, including idle pool blocks
+    int64_t bytesHeld() const { return held_; }
+    int64_t poolBytes() const { return poolBytes_; }
+    // live allocations
+    uint64_t allocations() const { return allocations_; }
+    // allocations made since creation, freed or not
+    uint64_t totalAllocations() const { return totalAllocations_; }
+    int64_t bytesReported() const { return reported_; }
+
+    static const int NUM_CLASSES = 10;
+
+private:
+    void* allocate(size_t size);
+    void freeBlock(char* block);
+    bool grow(int cls);
+
+    bool pooling_;
+    int64_t inUse_;
+    int64_t held_;
+    int64_t poolBytes_;
+    int64_t reported_;
+    uint64_t allocations_;
+    uint64_t totalAllocations_;
+    // free blocks per size class, linked through their payload
+    void* freeLists_[NUM_CLASSES];
+    std::vector<void*> slabs_;
+
+    GNAllocator(const GNAllocator&);
+    void operator=(const GNAllocator&);
+};
+
+#endif
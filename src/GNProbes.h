@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_PROBES_H_
+#define _GN_PROBES_H_
+
+// USDT / SystemTap SDT probes on the query path.  Each probe is a nop
+// until a tracer attaches, e.g.
+//   bpftrace -e 'usdt:./build/Release/getdns.node:getdns:query__done
+//                { @ns = hist(arg2); }'
+// Built when sys/sdt.h is available, see binding.gyp.
+
+#ifdef GN_ENABLE_USDT
+
+#include <sys/sdt.h>
+
+// id, name, rrtype (0 for helpers), lookup type
+#define GN_PROBE_QUERY_SUBMIT(id, name, type, lookup) \
+    DTRACE_PROBE4(getdns, query__submit, id, name, type, lookup)
+// id, callback type, nanos since issued to getdns
+#define GN_PROBE_QUERY_DONE(id, cbType, nanos) \
+    DTRACE_PROBE3(getdns, query__done, id, cbType, nanos)
+// id
+#define GN_PROBE_QUERY_CANCEL(id) \
+    DTRACE_PROBE1(getdns, query__cancel, id)
+// id
+#define GN_PROBE_CONVERT_START(id) \
+    DTRACE_PROBE1(getdns, convert__start, id)
+// id, nanos, objects and arrays, bindata bytes
+#define GN_PROBE_CONVERT_END(id, nanos, nodes, bytes) \
+    DTRACE_PROBE4(getdns, convert__end, id, nanos, nodes, bytes)
+// event, fd (-1 for timers), timeout millis
+#define GN_PROBE_EVENT_SCHEDULE(ev, fd, timeout) \
+    DTRACE_PROBE3(getdns, event__schedule, ev, fd, timeout)
+// event
+#define GN_PROBE_EVENT_CLEAR(ev) \
+    DTRACE_PROBE1(getdns, event__clear, ev)
+
+#else
+
+#define GN_PROBE_QUERY_SUBMIT(id, name, type, lookup) do { } while (0)
+#define GN_PROBE_QUERY_DONE(id, cbType, nanos) do { } while (0)
+#define GN_PROBE_QUERY_CANCEL(id) do { } while (0)
+#define GN_PROBE_CONVERT_START(id) do { } while (0)
+#define GN_PROBE_CONVERT_END(id, nanos, nodes, bytes) do { } while (0)
+#define GN_PROBE_EVENT_SCHEDULE(ev, fd, timeout) do { } while (0)
+#define GN_PROBE_EVENT_CLEAR(ev) do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GNReplay.h"
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const size_t DNS_HEADER_SIZE = 12;
+
+// Lower cased qname and qtype of the first question in a DNS message,
+// the key replies are found by.  Returns the offset past the question
+// or 0 if the message is malformed.
+static size_t questionKey(const uint8_t* wire, size_t len, std::string* key) {
+    size_t offset = DNS_HEADER_SIZE;
+    key->clear();
+    if (len < DNS_HEADER_SIZE || ((wire[4] << 8) | wire[5]) == 0) {
+        return 0;
+    }
+    for (;;) {
+        if (offset >= len) {
+            return 0;
+        }
+        uint8_t labelLen = wire[offset];
+        // no compression in the first name of a message
+        if (labelLen > 63 || offset + 1 + labelLen > len) {
+            return 0;
+        }
+        key->push_back((char) labelLen);
+        for (uint8_t i = 0; i < labelLen; ++i) {
+            key->push_back((char) tolower(wire[offset + 1 + i]));
+        }
+        offset += 1 + labelLen;
+        if (labelLen == 0) {
+            break;
+        }
+    }
+    if (offset + 4 > len) {
+        return 0;
+    }
+    key->append((const char*) wire + offset, 2);
+    return offset + 4;
+}
+
+static void putUint16(FILE* file, uint16_t v) {
+    uint8_t buf[2] = { (uint8_t) (v >> 8), (uint8_t) v };
+    fwrite(buf, 1, 2, file);
+}
+
+static void putUint32(FILE* file, uint32_t v) {
+    uint8_t buf[4] = { (uint8_t) (v >> 24), (uint8_t) (v >> 16),
+                       (uint8_t) (v >> 8), (uint8_t) v };
+    fwrite(buf, 1, 4, file);
+}
+
+static uint32_t getUint32(const uint8_t* p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+           ((uint32_t) p[2] << 8) | p[3];
+}
+
+static uint16_t getUint16(const uint8_t* p) {
+    return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+bool GNRecorder::open(const char* path) {
+    close();
+    file_ = fopen(path, "wb");
+    if (!file_) {
+        return false;
+    }
+    setvbuf(file_, NULL, _IOFBF, 1 << 16);
+    fwrite(GN_REPLAY_MAGIC, 1, 8, file_);
+    putUint32(file_, GN_REPLAY_VERSION);
+    records_ = 0;
+    return true;
+}
+
+void GNRecorder::close() {
+    if (file_) {
+        fclose(file_);
+        file_ = NULL;
+    }
+}
+
+void GNRecorder::record(getdns_dict* response, uint64_t latencyMicros) {
+    getdns_list* replies = NULL;
+    if (!file_ ||
+        getdns_dict_get_list(response, "replies_full", &replies) != GETDNS_RETURN_GOOD) {
+        return;
+    }
+    uint32_t latency = latencyMicros > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) latencyMicros;
+    size_t len = 0;
+    getdns_list_get_length(replies, &len);
+    std::string key;
+    for (size_t i = 0; i < len; ++i) {
+        getdns_bindata* wire = NULL;
+        if (getdns_list_get_bindata(replies, i, &wire) != GETDNS_RETURN_GOOD ||
+            wire->size > 0xFFFF || !questionKey(wire->data, wire->size, &key)) {
+            continue;
+        }
+        size_t nameLen = key.size() - 2;
+        putUint32(file_, latency);
+        fwrite(key.data() + nameLen, 1, 2, file_);
+        fputc((int) nameLen, file_);
+        fwrite(key.data(), 1, nameLen, file_);
+        putUint16(file_, (uint16_t) wire->size);
+        fwrite(wire->data, 1, wire->size, file_);
+        ++records_;
+    }
+}
+
+GNReplayServer::GNReplayServer() : fd_(-1), port_(0), handles_(0),
+    answered_(0), misses_(0) {
+}
+
+GNReplayServer::~GNReplayServer() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+GNReplayServer* GNReplayServer::start(const char* path, std::string* error) {
+    GNReplayServer* server = new GNReplayServer();
+    if (!server->load(path, error) || !server->listen(error)) {
+        delete server;
+        return NULL;
+    }
+    return server;
+}
+
+bool GNReplayServer::load(const char* path, std::string* error) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        *error = std::string("Unable to open ") + path + ": " + strerror(errno);
+        return false;
+    }
+    std::string data;
+    char buf[1 << 16];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        data.append(buf, n);
+    }
+    fclose(file);
+    const uint8_t* p = (const uint8_t*) data.data();
+    size_t len = data.size();
+    if (len < 12 || memcmp(p, GN_REPLAY_MAGIC, 8) != 0 ||
+        getUint32(p + 8) != GN_REPLAY_VERSION) {
+        *error = std::string(path) + " is not a recording";
+        return false;
+    }
+    size_t offset = 12;
+    while (offset < len) {
+        // latency, qtype and qname length
+        if (offset + 7 > len) {
+            break;
+        }
+        Reply reply;
+        reply.latencyMicros = getUint32(p + offset);
+        std::string type((const char*) p + offset + 4, 2);
+        size_t nameLen = p[offset + 6];
+        offset += 7;
+        if (offset + nameLen + 2 > len) {
+            break;
+        }
+        std::string key((const char*) p + offset, nameLen);
+        key += type;
+        offset += nameLen;
+        size_t wireLen = getUint16(p + offset);
+        offset += 2;
+        if (offset + wireLen > len) {
+            break;
+        }
+        reply.wire.assign((const char*) p + offset, wireLen);
+        offset += wireLen;
+        Replies& replies = replies_[key];
+        if (replies.replies.empty()) {
+            replies.next = 0;
+        }
+        replies.replies.push_back(reply);
+    }
+    if (offset != len) {
+        *error = std::string(path) + " is truncated";
+        return false;
+    }
+    return true;
+}
+
+bool GNReplayServer::listen(std::string* error) {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+        *error = std::string("Unable to create socket: ") + strerror(errno);
+        return false;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (bind(fd_, (struct sockaddr*) &addr, sizeof(addr)) != 0 ||
+        getsockname(fd_, (struct sockaddr*) &addr, &addrLen) != 0) {
+        *error = std::string("Unable to bind socket: ") + strerror(errno);
+        return false;
+    }
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    port_ = ntohs(addr.sin_port);
+
+    uv_poll_init(uv_default_loop(), &poll_, fd_);
+    uv_timer_init(uv_default_loop(), &timer_);
+    poll_.data = this;
+    timer_.data = this;
+    handles_ = 2;
+    uv_poll_start(&poll_, UV_READABLE, GNReplayServer::onReadable);
+    // the queries waiting for answers keep the loop alive, not the server
+    uv_unref((uv_handle_t*) &poll_);
+    uv_unref((uv_handle_t*) &timer_);
+    return true;
+}
+
+void GNReplayServer::close() {
+    if (handles_ == 0) {
+        delete this;
+        return;
+    }
+    uv_poll_stop(&poll_);
+    uv_timer_stop(&timer_);
+    uv_close((uv_handle_t*) &poll_, GNReplayServer::onClose);
+    uv_close((uv_handle_t*) &timer_, GNReplayServer::onClose);
+}
+
+void GNReplayServer::onClose(uv_handle_t* handle) {
+    GNReplayServer* server = static_cast<GNReplayServer*>(handle->data);
+    if (--server->handles_ == 0) {
+        delete server;
+    }
+}
+
+void GNReplayServer::onReadable(uv_poll_t* poll, int status, int events) {
+    static_cast<GNReplayServer*>(poll->data)->receive();
+}
+
+#if UV_VERSION_MAJOR == 0
+void GNReplayServer::onTimer(uv_timer_t* timer, int status)
+#else
+void GNReplayServer::onTimer(uv_timer_t* timer)
+#endif
+{
+    static_cast<GNReplayServer*>(timer->data)->sendDue();
+}
+
+void GNReplayServer::receive() {
+    uint8_t buf[65536];
+    std::string key;
+    for (;;) {
+        Answer answer;
+        answer.addrLen = sizeof(answer.addr);
+        ssize_t n = recvfrom(fd_, buf, sizeof(buf), 0,
+                             (struct sockaddr*) &answer.addr, &answer.addrLen);
+        if (n < 0) {
+            break;
+        }
+        size_t questionEnd = questionKey(buf, (size_t) n, &key);
+        if (!questionEnd) {
+            continue;
+        }
+        uint64_t due = uv_hrtime();
+        std::map<std::string, Replies>::iterator it = replies_.find(key);
+        if (it == replies_.end()) {
+            // not recorded, SERVFAIL with just the question
+            ++misses_;
+            answer.wire.assign((const char*) buf, questionEnd);
+            answer.wire[2] = (char) (0x80 | (buf[2] & 0x79));
+            answer.wire[3] = 2;
+            memset(&answer.wire[6], 0, 6);
+        } else {
+            Replies& replies = it->second;
+            const Reply& reply = replies.replies[replies.next];
+            replies.next = (replies.next + 1) % replies.replies.size();
+            answer.wire = reply.wire;
+            answer.wire[0] = (char) buf[0];
+            answer.wire[1] = (char) buf[1];
+            due += (uint64_t) reply.latencyMicros * 1000;
+        }
+        pending_.insert(std::make_pair(due, answer));
+    }
+    sendDue();
+}
+
+void GNReplayServer::sendDue() {
+    uint64_t now = uv_hrtime();
+    while (!pending_.empty() && pending_.begin()->first <= now) {
+        const Answer& answer = pending_.begin()->second;
+        sendto(fd_, answer.wire.data(), answer.wire.size(), 0,
+               (const struct sockaddr*) &answer.addr, answer.addrLen);
+        ++answered_;
+        pending_.erase(pending_.begin());
+    }
+    armTimer();
+}
+
+void GNReplayServer::armTimer() {
+    uv_timer_stop(&timer_);
+    if (pending_.empty()) {
+        return;
+    }
+    uint64_t now = uv_hrtime();
+    uint64_t due = pending_.begin()->first;
+    // round up so the answer is due when the timer fires
+    uint64_t ms = due > now ? (due - now + 999999) / 1000000 : 0;
+    uv_timer_start(&timer_, GNReplayServer::onTimer, ms, 0);
+}
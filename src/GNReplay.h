@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_REPLAY_H_
+#define _GN_REPLAY_H_
+
+#include <getdns/getdns.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <uv.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// Record and replay of upstream answers so the same traffic can be run
+// against different builds.
+//
+// The file starts with the 8 byte magic "GNREPLAY" and a version, then
+// has one record per reply, all integers big endian:
+//
+//   uint32  latency in micros, from issue to the getdns callback
+//   uint16  qtype
+//   uint8   qname length, then the qname in wire format, lower case
+//   uint16  reply length, then the reply as received
+static const char GN_REPLAY_MAGIC[] = "GNREPLAY";
+static const uint32_t GN_REPLAY_VERSION = 1;
+
+// Appends the replies of responses to a file.  Writes are buffered, the
+// file is complete once closed.
+class GNRecorder {
+public:
+    GNRecorder() : file_(NULL), records_(0) { }
+    ~GNRecorder() { close(); }
+
+    // Returns false if the file can not be created
+    bool open(const char* path);
+    void close();
+    bool recording() const { return file_ != NULL; }
+
+    // Record every reply in replies_full of response
+    void record(getdns_dict* response, uint64_t latencyMicros);
+
+    uint64_t records() const { return records_; }
+
+private:
+    FILE* file_;
+    uint64_t records_;
+};
+
+// A UDP responder on the loopback that answers from a recording with
+// the recorded latency.  Replies to the same question are handed out
+// in turn.  Runs on the default loop and frees itself once closed.
+class GNReplayServer {
+public:
+    // Load path and start listening.  Returns NULL and sets error on
+    // failure.
+    static GNReplayServer* start(const char* path, std::string* error);
+
+    // Stop answering and free the server once its handles are closed
+    void close();
+
+    uint16_t port() const { return port_; }
+    // answers sent and queries with no recorded reply
+    uint64_t answered() const { return answered_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    GNReplayServer();
+    ~GNReplayServer();
+
+    bool load(const char* path, std::string* error);
+    bool listen(std::string* error);
+    void receive();
+    void sendDue();
+    void armTimer();
+
+    static void onReadable(uv_poll_t* poll, int status, int events);
+#if UV_VERSION_MAJOR == 0
+    static void onTimer(uv_timer_t* timer, int status);
+#else
+    static void onTimer(uv_timer_t* timer);
+#endif
+    static void onClose(uv_handle_t* handle);
+
+    typedef struct Reply {
+        uint32_t latencyMicros;
+        std::string wire;
+    } Reply;
+
+    typedef struct Replies {
+        std::vector<Reply> replies;
+        size_t next;
+    } Replies;
+
+    typedef struct Answer {
+        struct sockaddr_storage addr;
+        socklen_t addrLen;
+        std::string wire;
+    } Answer;
+
+    // keyed by qname and qtype, see questionKey
+    std::map<std::string, Replies> replies_;
+    // answers held back, keyed by uv_hrtime() due
+    std::multimap<uint64_t, Answer> pending_;
+
+    int fd_;
+    uint16_t port_;
+    uv_poll_t poll_;
+    uv_timer_t timer_;
+    int handles_;
+    uint64_t answered_;
+    uint64_t misses_;
+};
+
+#endif
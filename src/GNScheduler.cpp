@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GNScheduler.h"
+
+#include <algorithm>
+
+GNScheduler::GNScheduler() : limit_(0), size_(0) { }
+
+GNScheduler::~GNScheduler() {
+    for (uint32_t l = 0; l < NUM_LANES; ++l) {
+        std::map<std::string, TenantQueue*>::iterator it;
+        for (it = lanes_[l].tenants.begin(); it != lanes_[l].tenants.end(); ++it) {
+            delete it->second;
+        }
+    }
+}
+
+void GNScheduler::setWeight(const std::string& tenant, uint32_t weight) {
+    weights_[tenant] = weight > 0 ? weight : 1;
+}
+
+void GNScheduler::clearWeights() {
+    weights_.clear();
+}
+
+uint32_t GNScheduler::weightOf(const std::string& tenant) const {
+    std::map<std::string, uint32_t>::const_iterator it = weights_.find(tenant);
+    return it == weights_.end() ? 1 : it->second;
+}
+
+void GNScheduler::push(CallbackData* data) {
+    uint32_t l = std::min(data->priority, NUM_LANES - 1);
+    Lane& lane = lanes_[l];
+    TenantQueue*& tq = lane.tenants[data->tenant];
+    if (!tq) {
+        tq = new TenantQueue();
+        tq->tenant = data->tenant;
+        tq->deficit = 0;
+    }
+    if (tq->queries.empty()) {
+        lane.active.push_back(tq);
+    }
+    tq->queries.push_back(data);
+    ++size_;
+}
+
+// Drop a tenant that has nothing queued
+void GNScheduler::retire(Lane& lane, TenantQueue* tq) {
+    lane.active.remove(tq);
+    lane.tenants.erase(tq->tenant);
+    delete tq;
+}
+
+CallbackData* GNScheduler::pop() {
+    // highest lane first
+    for (uint32_t l = NUM_LANES; l-- > 0;) {
+        Lane& lane = lanes_[l];
+        if (lane.active.empty()) {
+            continue;
+        }
+        TenantQueue* tq = lane.active.front();
+        if (tq->deficit == 0) {
+            // start of this tenant's turn
+            tq->deficit = weightOf(tq->tenant);
+        }
+        CallbackData* data = tq->queries.front();
+        tq->queries.pop_front();
+        --tq->deficit;
+        --size_;
+        if (tq->queries.empty()) {
+            retire(lane, tq);
+        } else if (tq->deficit == 0) {
+            // turn is over, go to the back
+            lane.active.pop_front();
+            lane.active.push_back(tq);
+        }
+        return data;
+    }
+    return NULL;
+}
+
+bool GNScheduler::remove(CallbackData* data) {
+    uint32_t l = std::min(data->priority, NUM_LANES - 1);
+    Lane& lane = lanes_[l];
+    std::map<std::string, TenantQueue*>::iterator it = lane.tenants.find(data->tenant);
+    if (it == lane.tenants.end()) {
+        return false;
+    }
+    TenantQueue* tq = it->second;
+    std::deque<CallbackData*>::iterator qit =
+        std::find(tq->queries.begin(), tq->queries.end(), data);
+    if (qit == tq->queries.end()) {
+        return false;
+    }
+    tq->queries.erase(qit);
+    --size_;
+    if (tq->queries.empty()) {
+        retire(lane, tq);
+    }
+    return true;
+}
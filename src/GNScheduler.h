@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_SCHEDULER_H_
+#define _GN_SCHEDULER_H_
+
+#include "GNCallbackData.h"
+
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+
+// Queues queries in front of getdns so a context shared by several
+// tenants hands out its outstanding query budget fairly.
+//
+// Queries are placed in a lane by priority.  Lanes are strict: a
+// higher priority lane is always drained before a lower one.  Within
+// a lane, tenants are served by deficit round robin using their
+// configured weight (default 1).
+class GNScheduler {
+public:
+    // Number of priority lanes.  Priorities above this are clamped.
+    static const uint32_t NUM_LANES = 4;
+
+    GNScheduler();
+    ~GNScheduler();
+
+    // Maximum number of scheduled queries outstanding in getdns.
+    // 0 disables scheduling.
+    void setLimit(uint32_t limit) { limit_ = limit; }
+    uint32_t getLimit() const { return limit_; }
+    bool enabled() const { return limit_ > 0; }
+    bool hasBudget(uint32_t inFlight) const {
+        return limit_ == 0 || inFlight < limit_;
+    }
+
+    // Tenant weights
+    void setWeight(const std::string& tenant, uint32_t weight);
+    void clearWeights();
+
+    // Queue operations
+    void push(CallbackData* data);
+    CallbackData* pop();
+    bool remove(CallbackData* data);
+    size_t size() const { return size_; }
+
+private:
+    typedef struct TenantQueue {
+        std::string tenant;
+        std::deque<CallbackData*> queries;
+        uint32_t deficit;
+    } TenantQueue;
+
+    typedef struct Lane {
+        // tenants with queued queries in round robin order
+        std::list<TenantQueue*> active;
+        std::map<std::string, TenantQueue*> tenants;
+    } Lane;
+
+    uint32_t weightOf(const std::string& tenant) const;
+    void retire(Lane& lane, TenantQueue* tq);
+
+    uint32_t limit_;
+    size_t size_;
+    Lane lanes_[NUM_LANES];
+    std::map<std::string, uint32_t> weights_;
+
+    GNScheduler(const GNScheduler&);
+    void operator=(const GNScheduler&);
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GNStats.h"
+
+#include <nan.h>
+#include <string.h>
+
+using namespace v8;
+
+GNHistogram::GNHistogram() {
+    reset();
+}
+
+void GNHistogram::reset() {
+    memset(buckets_, 0, sizeof(buckets_));
+    count_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+}
+
+int GNHistogram::bucketIndex(uint64_t value) {
+    if (value < (uint64_t) SUB_BUCKETS) {
+        return (int) value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BUCKET_BITS + 1;
+    int index = SUB_BUCKETS + (shift - 1) * HALF_BUCKETS +
+                (int) ((value >> shift) - HALF_BUCKETS);
+    return index < NUM_BUCKETS ? index : NUM_BUCKETS - 1;
+}
+
+uint64_t GNHistogram::bucketHighest(int index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int k = index - SUB_BUCKETS;
+    int shift = k / HALF_BUCKETS + 1;
+    uint64_t sub = k % HALF_BUCKETS + HALF_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void GNHistogram::record(uint64_t value) {
+    ++buckets_[bucketIndex(value)];
+    ++count_;
+    sum_ += value;
+    if (value < min_) {
+        min_ = value;
+    }
+    if (value > max_) {
+        max_ = value;
+    }
+}
+
+uint64_t GNHistogram::percentile(double p) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t) (p / 100.0 * count_ + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets_[i];
+        if (seen >= target) {
+            uint64_t highest = bucketHighest(i);
+            return highest < max_ ? highest : max_;
+        }
+    }
+    return max_;
+}
+
+Handle<Object> GNHistogram::toJSObj(double scale) const {
+    NanEscapableScope();
+    Local<Object> result = NanNew<Object>();
+    result->Set(NanNew<String>("count"), NanNew<Number>((double) count_));
+    result->Set(NanNew<String>("min"), NanNew<Number>(min() / scale));
+    result->Set(NanNew<String>("max"), NanNew<Number>(max_ / scale));
+    result->Set(NanNew<String>("mean"), NanNew<Number>(mean() / scale));
+    result->Set(NanNew<String>("p50"), NanNew<Number>(percentile(50) / scale));
+    result->Set(NanNew<String>("p90"), NanNew<Number>(percentile(90) / scale));
+    result->Set(NanNew<String>("p99"), NanNew<Number>(percentile(99) / scale));
+    result->Set(NanNew<String>("p999"), NanNew<Number>(percentile(99.9) / scale));
+    return NanEscapeScope(result);
+}
+
+void GNSlowSampler::offer(const char* name, uint16_t type, int lookupType,
+                          uint64_t nanos, const GNConvertStats& convert) {
+    if (!wants(nanos)) {
+        return;
+    }
+    int slot = size_;
+    if (size_ < NUM_SAMPLES) {
+        ++size_;
+    } else {
+        // replace the fastest
+        slot = 0;
+        for (int i = 1; i < NUM_SAMPLES; ++i) {
+            if (samples_[i].nanos < samples_[slot].nanos) {
+                slot = i;
+            }
+        }
+    }
+    GNSlowConversion& sample = samples_[slot];
+    sample.name = name;
+    sample.type = type;
+    sample.lookupType = lookupType;
+    sample.nanos = nanos;
+    sample.convert = convert;
+    if (size_ == NUM_SAMPLES) {
+        threshold_ = samples_[0].nanos;
+        for (int i = 1; i < NUM_SAMPLES; ++i) {
+            if (samples_[i].nanos < threshold_) {
+                threshold_ = samples_[i].nanos;
+            }
+        }
+    }
+}
+
+static const char* LOOKUP_NAMES[] = {
+    "address",
+    "hostname",
+    "service",
+    "general"
+};
+
+Handle<Array> GNSlowSampler::toJSArray() const {
+    NanEscapableScope();
+    Local<Array> result = NanNew<Array>();
+    for (int i = 0; i < size_; ++i) {
+        const GNSlowConversion& sample = samples_[i];
+        Local<Object> obj = NanNew<Object>();
+        obj->Set(NanNew<String>("name"), NanNew<String>(sample.name.c_str()));
+        obj->Set(NanNew<String>("type"), NanNew<Integer>(sample.type));
+        obj->Set(NanNew<String>("lookup"), NanNew<String>(LOOKUP_NAMES[sample.lookupType]));
+        obj->Set(NanNew<String>("time"), NanNew<Number>(sample.nanos / 1000.0));
+        obj->Set(NanNew<String>("nodes"), NanNew<Number>((double) sample.convert.nodes));
+        obj->Set(NanNew<String>("strings"), NanNew<Number>((double) sample.convert.strings));
+        obj->Set(NanNew<String>("buffers"), NanNew<Number>((double) sample.convert.buffers));
+        obj->Set(NanNew<String>("binary_bytes"), NanNew<Number>((double) sample.convert.binaryBytes));
+        result->Set(i, obj);
+    }
+    return NanEscapeScope(result);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_STATS_H_
+#define _GN_STATS_H_
+
+#include <node.h>
+#include <stdint.h>
+#include <string>
+
+#include "GNUtil.h"
+
+// Log linear histogram in the style of HdrHistogram.  Values below 32
+// get their own bucket, above that each power of two is split into 16
+// buckets, so a recorded value is off by at most 1/16th.
+class GNHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int HALF_BUCKETS = SUB_BUCKETS / 2;
+    // enough for values up to 2^36
+    static const int NUM_BUCKETS = SUB_BUCKETS + HALF_BUCKETS * 32;
+
+    GNHistogram();
+
+    void record(uint64_t value);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? (double) sum_ / count_ : 0; }
+    // highest value equivalent to the value at the given percentile
+    uint64_t percentile(double p) const;
+
+    // JS snapshot.  Values are divided by scale (e.g. 1000 for us -> ms)
+    v8::Handle<v8::Object> toJSObj(double scale) const;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketHighest(int index);
+
+private:
+    uint64_t buckets_[NUM_BUCKETS];
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
+// One of the slowest response conversions seen by a context
+typedef struct GNSlowConversion {
+    std::string name;
+    uint16_t type;
+    // LookupType of the query
+    int lookupType;
+    uint64_t nanos;
+    GNConvertStats convert;
+} GNSlowConversion;
+
+// Keeps the slowest conversions.  Cheap to offer a sample to since
+// anything faster than the fastest kept sample is rejected up front.
+class GNSlowSampler {
+public:
+    static const int NUM_SAMPLES = 8;
+
+    GNSlowSampler() : size_(0), threshold_(0) { }
+
+    bool wants(uint64_t nanos) const {
+        return size_ < NUM_SAMPLES || nanos > threshold_;
+    }
+    void offer(const char* name, uint16_t type, int lookupType,
+               uint64_t nanos, const GNConvertStats& convert);
+    v8::Handle<v8::Array> toJSArray() const;
+
+private:
+    GNSlowConversion samples_[NUM_SAMPLES];
+    int size_;
+    // fastest kept sample once full
+    uint64_t threshold_;
+};
+
+// Per context counters
+typedef struct GNStats {
+    uint64_t issued;
+    uint64_t completed;
+    uint64_t timedOut;
+    uint64_t cancelled;
+    uint64_t errored;
+    uint64_t inFlight;
+    uint64_t bytesConverted;
+    // micros from getdns submission to callback
+    GNHistogram latency;
+
+    // response conversion cost
+    GNHistogram convertNanos;
+    uint64_t convertNodes;
+    uint64_t convertStrings;
+    uint64_t convertBuffers;
+    GNSlowSampler slowConversions;
+} GNStats;
+
+// Per upstream counters.  Responses are matched to an upstream by
+// address and port from the getdns call debugging information.
+typedef struct GNUpstreamStats {
+    // as configured
+    std::string address;
+    uint32_t port;
+    // address bytes for matching
+    uint8_t addr[16];
+    size_t addrLen;
+    uint64_t responses;
+    uint64_t timeouts;
+    uint64_t rcodes[16];
+    // millis as reported by getdns
+    GNHistogram rtt;
+} GNUpstreamStats;
+
+#endif
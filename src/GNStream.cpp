@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GNStream.h"
+#include "GNContext.h"
+#include "GNUtil.h"
+
+#include <stdio.h>
+
+#ifdef GN_STUB_GETDNS
+// benchmarks only, see bench/native/GNStub.h
+#include "GNStub.h"
+#endif
+
+using namespace v8;
+
+// Output buffered before queries are held back for the writes
+static const size_t OUTPUT_HIGH_WATER = 1 << 20;
+
+// left out of the JSON responses, the wire format of replies_tree
+static const char* SKIPPED_NAMES[] = {
+    "replies_full",
+    NULL
+};
+
+GNStream::GNStream() : ctx_(NULL), inFd_(-1), outFd_(-1), type_(0),
+    extension_(NULL), window_(1), callback_(NULL), reading_(false),
+    eof_(false), writeOffset_(0), writing_(false), inFlight_(0),
+    pumping_(false), stopped_(false), error_(NULL), namesRead_(0), answered_(0),
+    failed_(0), bytesWritten_(0) {
+}
+
+GNStream::~GNStream() {
+    if (extension_) {
+        getdns_dict_destroy(extension_);
+    }
+    delete callback_;
+}
+
+void GNStream::start(GNContext* ctx, int inFd, int outFd, uint16_t type,
+                     getdns_dict* extension, uint32_t window,
+                     NanCallback* callback) {
+    GNStream* stream = new GNStream();
+    stream->ctx_ = ctx;
+    stream->inFd_ = inFd;
+    stream->outFd_ = outFd;
+    stream->type_ = type;
+    stream->extension_ = extension;
+    stream->window_ = window > 0 ? window : 1;
+    stream->callback_ = callback;
+    // keep the context alive until the stream is done
+    ctx->Ref();
+    stream->pump();
+}
+
+void GNStream::readMore() {
+    reading_ = true;
+    readReq_.data = this;
+#if UV_VERSION_MAJOR == 0
+    int r = uv_fs_read(uv_default_loop(), &readReq_, inFd_, readBuf_,
+                       sizeof(readBuf_), -1, GNStream::ReadCallback);
+#else
+    uv_buf_t buf = uv_buf_init(readBuf_, sizeof(readBuf_));
+    int r = uv_fs_read(uv_default_loop(), &readReq_, inFd_, &buf, 1, -1,
+                       GNStream::ReadCallback);
+#endif
+    if (r < 0) {
+        reading_ = false;
+        eof_ = true;
+        fail("Unable to read input.");
+    }
+}
+
+void GNStream::ReadCallback(uv_fs_t* req) {
+    GNStream* stream = static_cast<GNStream*>(req->data);
+    ssize_t result = req->result;
+    uv_fs_req_cleanup(req);
+    stream->onRead(result);
+}
+
+// Queue the name on a line unless it is blank or a comment
+static void queueName(std::string line, std::deque<std::string>& names) {
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') {
+        return;
+    }
+    size_t end = line.find_last_not_of(" \t\r");
+    names.push_back(line.substr(start, end - start + 1));
+}
+
+void GNStream::onRead(ssize_t result) {
+    reading_ = false;
+    if (result < 0) {
+        eof_ = true;
+        fail("Unable to read input.");
+    } else if (result == 0) {
+        eof_ = true;
+        if (!partial_.empty()) {
+            size_t before = names_.size();
+            queueName(partial_, names_);
+            namesRead_ += names_.size() - before;
+            partial_.clear();
+        }
+    } else {
+        partial_.append(readBuf_, (size_t) result);
+        size_t start = 0, newline;
+        while ((newline = partial_.find('\n', start)) != std::string::npos) {
+            size_t before = names_.size();
+            queueName(partial_.substr(start, newline - start), names_);
+            namesRead_ += names_.size() - before;
+            start = newline + 1;
+        }
+        partial_.erase(0, start);
+    }
+    pump();
+}
+
+void GNStream::pump() {
+    if (pumping_) {
+        // a callback from within issue or flush, the outer pump goes on
+        return;
+    }
+    pumping_ = true;
+    if (!ctx_->context_) {
+        fail("Context destroyed.");
+    }
+    while (!stopped_ && ctx_->context_ && inFlight_ < window_ &&
+           !names_.empty() && out_.size() < OUTPUT_HIGH_WATER) {
+        std::string name = names_.front();
+        names_.pop_front();
+        issue(name);
+    }
+    if (!stopped_ && !reading_ && !eof_ && names_.size() < window_) {
+        readMore();
+    }
+    flush();
+    pumping_ = false;
+    maybeFinish();
+}
+
+static void appendName(const std::string& name, std::string* out) {
+    out->append("{\"name\":");
+    GNUtil::appendJSONString(name.c_str(), name.size(), out);
+}
+
+static void appendError(const char* msg, int code, std::string* out) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), ",\"error\":{\"msg\":\"%s\",\"code\":%d}}\n",
+             msg, code);
+    out->append(buf);
+}
+
+void GNStream::issue(const std::string& name) {
+    Query* query = new Query();
+    query->stream = this;
+    query->name = name;
+    getdns_transaction_t transId;
+    getdns_return_t r;
+    // counted before the call for a callback from within it
+    ++inFlight_;
+    if (type_ == 0) {
+        r = getdns_address(ctx_->context_, name.c_str(), extension_,
+                           query, &transId, GNStream::QueryCallback);
+    } else {
+        r = getdns_general(ctx_->context_, name.c_str(), type_, extension_,
+                           query, &transId, GNStream::QueryCallback);
+    }
+    if (r != GETDNS_RETURN_GOOD) {
+        --inFlight_;
+        ++failed_;
+        appendName(name, &out_);
+        appendError("Error issuing query", r, &out_);
+        delete query;
+    }
+}
+
+void GNStream::QueryCallback(getdns_context* context,
+                             getdns_callback_type_t cbType,
+                             getdns_dict* response,
+                             void* userArg,
+                             getdns_transaction_t transId) {
+    Query* query = static_cast<Query*>(userArg);
+    GNStream* stream = query->stream;
+    --stream->inFlight_;
+    appendName(query->name, &stream->out_);
+    if (cbType == GETDNS_CALLBACK_COMPLETE) {
+        ++stream->answered_;
+        stream->out_.append(",\"response\":");
+        GNUtil::convertToJSON(response, &stream->out_, SKIPPED_NAMES);
+        stream->out_.append("}\n");
+        getdns_dict_destroy(response);
+    } else {
+        ++stream->failed_;
+        appendError("Lookup failed.", cbType, &stream->out_);
+        if (cbType == GETDNS_CALLBACK_CANCEL) {
+            // only the context going away cancels stream queries
+            stream->stopped_ = true;
+            stream->error_ = "Context destroyed.";
+        }
+    }
+    delete query;
+    stream->pump();
+}
+
+void GNStream::flush() {
+    if (outFd_ < 0) {
+        // output failed, results are dropped
+        out_.clear();
+        return;
+    }
+    if (writing_ || out_.empty()) {
+        return;
+    }
+    writeBuf_.swap(out_);
+    out_.clear();
+    writeOffset_ = 0;
+    writeMore();
+}
+
+void GNStream::writeMore() {
+    writing_ = true;
+    writeReq_.data = this;
+    char* data = &writeBuf_[writeOffset_];
+    size_t len = writeBuf_.size() - writeOffset_;
+#if UV_VERSION_MAJOR == 0
+    int r = uv_fs_write(uv_default_loop(), &writeReq_, outFd_, data, len, -1,
+                        GNStream::WriteCallback);
+#else
+    uv_buf_t buf = uv_buf_init(data, len);
+    int r = uv_fs_write(uv_default_loop(), &writeReq_, outFd_, &buf, 1, -1,
+                        GNStream::WriteCallback);
+#endif
+    if (r < 0) {
+        writing_ = false;
+        onWrite(-1);
+    }
+}
+
+void GNStream::WriteCallback(uv_fs_t* req) {
+    GNStream* stream = static_cast<GNStream*>(req->data);
+    ssize_t result = req->result;
+    uv_fs_req_cleanup(req);
+    stream->onWrite(result);
+}
+
+void GNStream::onWrite(ssize_t result) {
+    writing_ = false;
+    if (result < 0) {
+        // nowhere to write results, drop them and stop
+        outFd_ = -1;
+        writeBuf_.clear();
+        fail("Unable to write output.");
+        pump();
+        return;
+    }
+    bytesWritten_ += (uint64_t) result;
+    writeOffset_ += (size_t) result;
+    if (writeOffset_ < writeBuf_.size()) {
+        writeMore();
+        return;
+    }
+    writeBuf_.clear();
+    pump();
+}
+
+void GNStream::fail(const char* error) {
+    stopped_ = true;
+    if (!error_) {
+        error_ = error;
+    }
+}
+
+void GNStream::maybeFinish() {
+    if (inFlight_ > 0 || reading_ || writing_ || !out_.empty()) {
+        return;
+    }
+    if (!stopped_ && (!eof_ || !names_.empty())) {
+        return;
+    }
+    NanScope();
+    Local<Object> summary = NanNew<Object>();
+    summary->Set(NanNew<String>("names"), NanNew<Number>((double) namesRead_));
+    summary->Set(NanNew<String>("answered"), NanNew<Number>((double) answered_));
+    summary->Set(NanNew<String>("failed"), NanNew<Number>((double) failed_));
+    summary->Set(NanNew<String>("bytes_written"), NanNew<Number>((double) bytesWritten_));
+    Handle<Value> argv[2];
+    if (error_) {
+        Local<Object> err = NanNew<Object>();
+        err->Set(NanNew<String>("msg"), NanNew<String>(error_));
+        err->Set(NanNew<String>("code"), NanNew<Integer>(GETDNS_RETURN_GENERIC_ERROR));
+        argv[0] = err;
+    } else {
+        argv[0] = NanNull();
+    }
+    argv[1] = summary;
+    GNContext* ctx = ctx_;
+    NanCallback* callback = callback_;
+    callback_ = NULL;
+    delete this;
+    TryCatch try_catch;
+    NanMakeCallback(NanGetCurrentContext()->Global(), callback->GetFunction(), 2, argv);
+    delete callback;
+    ctx->Unref();
+    if (try_catch.HasCaught()) {
+        node::FatalException(try_catch);
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_STREAM_H_
+#define _GN_STREAM_H_
+
+#include <nan.h>
+#include <getdns/getdns.h>
+#include <uv.h>
+#include <deque>
+#include <string>
+
+class GNContext;
+
+// Bulk resolution from a file descriptor to a file descriptor without
+// going through JS per name.  Reads newline separated names from inFd,
+// keeps up to window of them in flight and writes one JSON line per
+// result to outFd in the order they complete:
+//
+//   {"name":"<name>","response":{...}}
+//   {"name":"<name>","error":{"msg":"...","code":<callback type>}}
+//
+// The response is converted as for lookup callbacks with replies_full
+// left out and binary data as {"$bin":"<hex>"}.  Blank lines and lines
+// starting with # are skipped.  The callback runs once, when input is
+// exhausted and all output written, or when the context is destroyed.
+// Queries are handed to getdns directly, outside the context's
+// scheduler, stats, trace, recorder and upstream stats.
+class GNStream {
+public:
+    // type 0 resolves addresses as getAddress does.  Takes ownership of
+    // extension and callback.
+    static void start(GNContext* ctx, int inFd, int outFd, uint16_t type,
+                      getdns_dict* extension, uint32_t window,
+                      NanCallback* callback);
+
+private:
+    GNStream();
+    ~GNStream();
+
+    // Issue names while the window and the output buffer allow and
+    // read more when running low
+    void pump();
+    void issue(const std::string& name);
+    void readMore();
+    void onRead(ssize_t result);
+    void flush();
+    void writeMore();
+    void onWrite(ssize_t result);
+    void fail(const char* error);
+    void maybeFinish();
+
+    static void ReadCallback(uv_fs_t* req);
+    static void WriteCallback(uv_fs_t* req);
+    static void QueryCallback(getdns_context* context,
+                              getdns_callback_type_t cbType,
+                              getdns_dict* response,
+                              void* userArg,
+                              getdns_transaction_t transId);
+
+    typedef struct Query {
+        GNStream* stream;
+        std::string name;
+    } Query;
+
+    GNContext* ctx_;
+    int inFd_;
+    int outFd_;
+    uint16_t type_;
+    getdns_dict* extension_;
+    uint32_t window_;
+    NanCallback* callback_;
+
+    // input
+    uv_fs_t readReq_;
+    char readBuf_[65536];
+    std::string partial_;
+    std::deque<std::string> names_;
+    bool reading_;
+    bool eof_;
+
+    // output, written a buffer at a time
+    uv_fs_t writeReq_;
+    std::string out_;
+    std::string writeBuf_;
+    size_t writeOffset_;
+    bool writing_;
+
+    uint32_t inFlight_;
+    // set while pump runs, so callbacks from getdns within it do not
+    // pump again
+    bool pumping_;
+    // no more queries are issued once stopped
+    bool stopped_;
+    const char* error_;
+
+    uint64_t namesRead_;
+    uint64_t answered_;
+    uint64_t failed_;
+    uint64_t bytesWritten_;
+};
+
+#endif
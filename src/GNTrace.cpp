@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "GNTrace.h"
+
+#include <nan.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace v8;
+
+void GNTraceRing::setCapacity(size_t capacity) {
+    events_.clear();
+    events_.resize(capacity);
+    next_ = 0;
+    size_ = 0;
+}
+
+void GNTraceRing::record(uint64_t id, GNTracePhase phase, uint64_t ts,
+                         const char* name, uint16_t type) {
+    if (events_.empty()) {
+        return;
+    }
+    GNTraceEvent& ev = events_[next_];
+    ev.id = id;
+    ev.ts = ts;
+    ev.phase = phase;
+    ev.type = type;
+    if (name) {
+        strncpy(ev.name, name, NAME_SIZE - 1);
+        ev.name[NAME_SIZE - 1] = 0;
+    } else {
+        ev.name[0] = 0;
+    }
+    next_ = (next_ + 1) % events_.size();
+    if (size_ < events_.size()) {
+        ++size_;
+    }
+}
+
+// Chrome trace event name and phase for each lifecycle phase.  The
+// query and its conversion and callback are async spans, the rest are
+// instant events on the query.
+static const char* PHASE_NAMES[] = {
+    "query", "issue", "response", "convert", "convert",
+    "callback", "callback", "query"
+};
+static const char* PHASE_TYPES[] = {
+    "b", "n", "n", "b", "e", "b", "e", "e"
+};
+
+Handle<Array> GNTraceRing::drain() {
+    NanEscapableScope();
+    Local<Array> result = NanNew<Array>();
+    size_t start = (next_ + events_.size() - size_) % (events_.empty() ? 1 : events_.size());
+    int pid = getpid();
+    char idStr[24];
+    for (size_t i = 0; i < size_; ++i) {
+        const GNTraceEvent& ev = events_[(start + i) % events_.size()];
+        Local<Object> obj = NanNew<Object>();
+        obj->Set(NanNew<String>("name"), NanNew<String>(PHASE_NAMES[ev.phase]));
+        obj->Set(NanNew<String>("cat"), NanNew<String>("getdns"));
+        obj->Set(NanNew<String>("ph"), NanNew<String>(PHASE_TYPES[ev.phase]));
+        snprintf(idStr, sizeof(idStr), "0x%llx", (unsigned long long) ev.id);
+        obj->Set(NanNew<String>("id"), NanNew<String>(idStr));
+        // micros
+        obj->Set(NanNew<String>("ts"), NanNew<Number>(ev.ts / 1000.0));
+        obj->Set(NanNew<String>("pid"), NanNew<Integer>(pid));
+        obj->Set(NanNew<String>("tid"), NanNew<Integer>(0));
+        if (ev.phase == GNTraceSubmit) {
+            Local<Object> args = NanNew<Object>();
+            args->Set(NanNew<String>("name"), NanNew<String>(ev.name));
+            args->Set(NanNew<String>("type"), NanNew<Integer>(ev.type));
+            obj->Set(NanNew<String>("args"), args);
+        }
+        result->Set(i, obj);
+    }
+    next_ = 0;
+    size_ = 0;
+    return NanEscapeScope(result);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2014, Verisign, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the names of the copyright holders nor the
+ *   names of its contributors may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Verisign, Inc. BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GN_TRACE_H_
+#define _GN_TRACE_H_
+
+#include <node.h>
+#include <stdint.h>
+#include <vector>
+
+// Query lifecycle phases
+typedef enum GNTracePhase {
+    // lookup called
+    GNTraceSubmit = 0,
+    // handed to getdns, which sends it upstream
+    GNTraceIssue,
+    // getdns called back
+    GNTraceResponse,
+    GNTraceConvertStart,
+    GNTraceConvertEnd,
+    GNTraceCallbackStart,
+    GNTraceCallbackEnd,
+    // query finished
+    GNTraceDone
+} GNTracePhase;
+
+// Fixed size ring of query lifecycle events.  Recording is a copy into
+// a preallocated slot, the oldest events are overwritten when full.
+// Drained as Chrome trace event format objects so they can be merged
+// with other traces.
+class GNTraceRing {
+public:
+    static const size_t NAME_SIZE = 64;
+
+    GNTraceRing() : next_(0), size_(0) { }
+
+    // capacity of 0 disables tracing
+    void setCapacity(size_t capacity);
+    size_t capacity() const { return events_.size(); }
+    bool enabled() const { return !events_.empty(); }
+
+    // ts is a uv_hrtime() timestamp
+    void record(uint64_t id, GNTracePhase phase, uint64_t ts,
+                const char* name = NULL, uint16_t type = 0);
+
+    // Remove all recorded events and return them as an array
+    v8::Handle<v8::Array> drain();
+
+private:
+    typedef struct GNTraceEvent {
+        uint64_t id;
+        uint64_t ts;
+        GNTracePhase phase;
+        uint16_t type;
+        // only for GNTraceSubmit
+        char name[NAME_SIZE];
+    } GNTraceEvent;
+
+    std::vector<GNTraceEvent> events_;
+    size_t next_;
+    size_t size_;
+};
+
+#endif
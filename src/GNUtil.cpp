@@ -33,189 +33,11 @@
 #include <node_buffer.h>
 #include <string_bytes.h>
 #include "GNUtil.h"
+#include "GNLibuv.h"
 
 #include <ctype.h>
-#include <string.h>
-
-// Mostly copied from getdns lib_uv extension but is long lived
-// until explicit free
-
-#include <sys/time.h>
 #include <stdio.h>
-#include <uv.h>
-
-typedef struct getdns_libuv {
-    getdns_eventloop_vmt *vmt;
-    uv_loop_t            *loop;
-} getdns_libuv;
-
-static void
-getdns_libuv_run(getdns_eventloop *loop)
-{
-    (void) uv_run(((getdns_libuv *)loop)->loop, UV_RUN_DEFAULT);
-}
-
-static void
-getdns_libuv_run_once(getdns_eventloop *loop, int blocking)
-{
-    (void) uv_run(((getdns_libuv *)loop)->loop,
-        blocking ? UV_RUN_ONCE : UV_RUN_NOWAIT);
-}
-
-static void
-getdns_libuv_cleanup(getdns_eventloop *loop)
-{
-    getdns_libuv *ext = (getdns_libuv *)loop;
-    free(ext);
-}
-
-typedef struct poll_timer {
-    uv_poll_t        read;
-    uv_poll_t        write;
-    uv_timer_t       timer;
-    int              to_close;
-} poll_timer;
-
-static void
-getdns_libuv_close_cb(uv_handle_t *handle)
-{
-    poll_timer *my_ev = (poll_timer *)handle->data;
-
-    if (--my_ev->to_close) {
-        return;
-    }
-    free(my_ev);
-}
-
-static getdns_return_t
-getdns_libuv_clear(getdns_eventloop *loop, getdns_eventloop_event *el_ev)
-{
-    poll_timer   *my_ev = (poll_timer *)el_ev->ev;
-    uv_poll_t    *my_poll;
-    uv_timer_t   *my_timer;
-
-    assert(my_ev);
-
-    if (el_ev->read_cb) {
-        my_poll = &my_ev->read;
-        uv_poll_stop(my_poll);
-        my_ev->to_close += 1;
-        my_poll->data = my_ev;
-        uv_close((uv_handle_t *)my_poll, getdns_libuv_close_cb);
-    }
-    if (el_ev->write_cb) {
-        my_poll = &my_ev->write;
-        uv_poll_stop(my_poll);
-        my_ev->to_close += 1;
-        my_poll->data = my_ev;
-        uv_close((uv_handle_t *)my_poll, getdns_libuv_close_cb);
-    }
-    if (el_ev->timeout_cb) {
-        my_timer = &my_ev->timer;
-        uv_timer_stop(my_timer);
-        my_ev->to_close += 1;
-        my_timer->data = my_ev;
-        uv_close((uv_handle_t *)my_timer, getdns_libuv_close_cb);
-    }
-    el_ev->ev = NULL;
-    return GETDNS_RETURN_GOOD;
-}
-
-static void
-getdns_libuv_read_cb(uv_poll_t *poll, int status, int events)
-{
-        getdns_eventloop_event *el_ev = (getdns_eventloop_event *)poll->data;
-        assert(el_ev->read_cb);
-        el_ev->read_cb(el_ev->userarg);
-}
-
-static void
-getdns_libuv_write_cb(uv_poll_t *poll, int status, int events)
-{
-        getdns_eventloop_event *el_ev = (getdns_eventloop_event *)poll->data;
-        assert(el_ev->write_cb);
-        el_ev->write_cb(el_ev->userarg);
-}
-
-static void
-#if UV_VERSION_MAJOR == 0
-getdns_libuv_timeout_cb(uv_timer_t *timer, int status)
-#else
-getdns_libuv_timeout_cb(uv_timer_t *timer)
-#endif
-{
-        getdns_eventloop_event *el_ev = (getdns_eventloop_event *)timer->data;
-        assert(el_ev->timeout_cb);
-        el_ev->timeout_cb(el_ev->userarg);
-}
-
-static getdns_return_t
-getdns_libuv_schedule(getdns_eventloop *loop,
-    int fd, uint64_t timeout, getdns_eventloop_event *el_ev)
-{
-    getdns_libuv *ext = (getdns_libuv *)loop;
-    poll_timer   *my_ev;
-    uv_poll_t    *my_poll;
-    uv_timer_t   *my_timer;
-
-    assert(el_ev);
-    assert(!(el_ev->read_cb || el_ev->write_cb) || fd >= 0);
-    assert(  el_ev->read_cb || el_ev->write_cb  || el_ev->timeout_cb);
-
-    my_ev = (poll_timer*)malloc(sizeof(poll_timer));
-    if (!my_ev)
-        return GETDNS_RETURN_MEMORY_ERROR;
-
-    my_ev->to_close = 0;
-    el_ev->ev = my_ev;
-
-    if (el_ev->read_cb) {
-        my_poll = &my_ev->read;
-        my_poll->data = el_ev;
-        uv_poll_init(ext->loop, my_poll, fd);
-        uv_poll_start(my_poll, UV_READABLE, getdns_libuv_read_cb);
-    }
-    if (el_ev->write_cb) {
-        my_poll = &my_ev->write;
-        my_poll->data = el_ev;
-        uv_poll_init(ext->loop, my_poll, fd);
-        uv_poll_start(my_poll, UV_WRITABLE, getdns_libuv_write_cb);
-    }
-    if (el_ev->timeout_cb) {
-        my_timer = &my_ev->timer;
-        my_timer->data = el_ev;
-        uv_timer_init(ext->loop, my_timer);
-        uv_timer_start(my_timer, getdns_libuv_timeout_cb, timeout, 0);
-    }
-    return GETDNS_RETURN_GOOD;
-}
-
-getdns_return_t
-getdns_extension_set_libuv_loop(getdns_context *context, uv_loop_t *loop)
-{
-    static getdns_eventloop_vmt getdns_libuv_vmt = {
-        getdns_libuv_cleanup,
-        getdns_libuv_schedule,
-        getdns_libuv_clear,
-        getdns_libuv_run,
-        getdns_libuv_run_once
-    };
-    getdns_libuv *ext;
-
-    if (!context)
-        return GETDNS_RETURN_BAD_CONTEXT;
-    if (!loop)
-        return GETDNS_RETURN_INVALID_PARAMETER;
-
-    ext = (getdns_libuv*)malloc(sizeof(getdns_libuv));
-    if (!ext)
-        return GETDNS_RETURN_MEMORY_ERROR;
-    ext->vmt  = &getdns_libuv_vmt;
-    ext->loop = loop;
-
-    return getdns_context_set_eventloop(context, (getdns_eventloop *)ext);
-}
-
+#include <string.h>
 
 /*
  * Call
@@ -251,11 +73,18 @@ priv_getdns_bindata_is_dname(struct getdns_bindata *bindata)
 }
 
 
-// Convert bindata into a good representational string or
-// into a buffer.  Handles dname, printable, ".",
-// and an ip address if it is under a known key
-static Handle<Value> convertBinData(getdns_bindata* data,
-                                    const char* key) {
+// How bindata is represented, shared by the JS and JSON conversions
+typedef enum BinDataKind {
+    BinPrintable,
+    BinRoot,
+    BinDname,
+    BinIpAddress,
+    BinBuffer
+} BinDataKind;
+
+// Classify bindata as a printable string, ".", a dname, an ip address
+// if it is under a known key or anything else
+static BinDataKind classifyBinData(getdns_bindata* data, const char* key) {
     bool printable = true;
     for (size_t i = 0; i < data->size; ++i) {
         if (!isprint(data->data[i])) {
@@ -267,37 +96,73 @@ static Handle<Value> convertBinData(getdns_bindata* data,
             break;
         }
     }
-    // basic string?
     if (printable) {
-        return NanNew<String>( (char*) data->data, data->size );
-    // the root
+        return BinPrintable;
     } else if (data->size == 1 && data->data[0] == 0) {
-        return NanNew<String>(".");
-    // dname
+        return BinRoot;
     } else if (priv_getdns_bindata_is_dname(data)) {
-        char* dname = NULL;
-        if (getdns_convert_dns_name_to_fqdn(data, &dname)
-            == GETDNS_RETURN_GOOD) {
-            Handle<Value> result = NanNew<String>(dname);
-            free(dname);
-            return result;
-        }
-    // ip address
+        return BinDname;
     } else if (key != NULL &&
         (strcmp(key, "ipv4_address") == 0 ||
          strcmp(key, "ipv6_address") == 0)) {
-        char* ipStr = getdns_display_ip_address(data);
-        if (ipStr) {
-            Handle<Value> result = NanNew<String>(ipStr);
-            free(ipStr);
-            return result;
+        return BinIpAddress;
+    }
+    return BinBuffer;
+}
+
+// Convert bindata into a good representational string or
+// into a buffer.
+static Handle<Value> convertBinDataValue(getdns_bindata* data,
+                                         const char* key) {
+    switch (classifyBinData(data, key)) {
+        case BinPrintable:
+            return NanNew<String>( (char*) data->data, data->size );
+        case BinRoot:
+            return NanNew<String>(".");
+        case BinDname:
+        {
+            char* dname = NULL;
+            if (getdns_convert_dns_name_to_fqdn(data, &dname)
+                == GETDNS_RETURN_GOOD) {
+                Handle<Value> result = NanNew<String>(dname);
+                free(dname);
+                return result;
+            }
+            break;
+        }
+        case BinIpAddress:
+        {
+            char* ipStr = getdns_display_ip_address(data);
+            if (ipStr) {
+                Handle<Value> result = NanNew<String>(ipStr);
+                free(ipStr);
+                return result;
+            }
+            break;
         }
+        default:
+            break;
     }
     // getting here implies we don't know how to convert it
     // to a string.
     return GNUtil::convertToBuffer(data->data, data->size);
 }
 
+static Handle<Value> convertBinData(getdns_bindata* data,
+                                    const char* key,
+                                    GNConvertStats* stats) {
+    Handle<Value> result = convertBinDataValue(data, key);
+    if (stats) {
+        stats->binaryBytes += data->size;
+        if (result->IsString()) {
+            ++stats->strings;
+        } else {
+            ++stats->buffers;
+        }
+    }
+    return result;
+}
+
 Handle<Value> GNUtil::convertToBuffer(void* data, size_t size) {
     //construct a new buffer of the size we need.
     Local<Object> nodeBuffer = NanNewBufferHandle(size);
@@ -307,7 +172,8 @@ Handle<Value> GNUtil::convertToBuffer(void* data, size_t size) {
     return nodeBuffer;
 }
 
-Handle<Value> GNUtil::convertToJSArray(struct getdns_list* list) {
+Handle<Value> GNUtil::convertToJSArray(struct getdns_list* list,
+                                       GNConvertStats* stats) {
     NanEscapableScope();
     if (!list) {
         return NanEscapeScope(NanNull());
@@ -315,6 +181,9 @@ Handle<Value> GNUtil::convertToJSArray(struct getdns_list* list) {
     size_t len;
     getdns_list_get_length(list, &len);
     Handle<Array> array = NanNew<Array>();
+    if (stats) {
+        ++stats->nodes;
+    }
     for (size_t i = 0; i < len; ++i) {
         getdns_data_type type;
         getdns_list_get_data_type(list, i, &type);
@@ -323,7 +192,7 @@ Handle<Value> GNUtil::convertToJSArray(struct getdns_list* list) {
             {
                 getdns_bindata* data = NULL;
                 getdns_list_get_bindata(list, i, &data);
-                array->Set(i, convertBinData(data, NULL));
+                array->Set(i, convertBinData(data, NULL, stats));
                 break;
             }
             case t_int:
@@ -337,14 +206,14 @@ Handle<Value> GNUtil::convertToJSArray(struct getdns_list* list) {
             {
                 getdns_dict* dict = NULL;
                 getdns_list_get_dict(list, i, &dict);
-                array->Set(i, GNUtil::convertToJSObj(dict));
+                array->Set(i, GNUtil::convertToJSObj(dict, stats));
                 break;
             }
             case t_list:
             {
                 getdns_list* sublist = NULL;
                 getdns_list_get_list(list, i, &sublist);
-                array->Set(i, GNUtil::convertToJSArray(sublist));
+                array->Set(i, GNUtil::convertToJSArray(sublist, stats));
                 break;
             }
             default:
@@ -378,7 +247,8 @@ char* getdns_dict_to_ip_string(getdns_dict* dict) {
 }
 
 
-Handle<Value> GNUtil::convertToJSObj(struct getdns_dict* dict) {
+Handle<Value> GNUtil::convertToJSObj(struct getdns_dict* dict,
+                                     GNConvertStats* stats) {
     NanEscapableScope();
     if (!dict) {
         return NanEscapeScope(NanNull());
@@ -389,6 +259,9 @@ Handle<Value> GNUtil::convertToJSObj(struct getdns_dict* dict) {
     if (ipStr) {
         Handle<Value> result = NanNew<String>(ipStr);
         free(ipStr);
+        if (stats) {
+            ++stats->strings;
+        }
         return NanEscapeScope(result);
     }
 
@@ -396,6 +269,9 @@ Handle<Value> GNUtil::convertToJSObj(struct getdns_dict* dict) {
     getdns_dict_get_names(dict, &names);
     size_t len = 0;
     Handle<Object> result = NanNew<Object>();
+    if (stats) {
+        ++stats->nodes;
+    }
     getdns_list_get_length(names, &len);
     for (size_t i = 0; i < len; ++i) {
         getdns_bindata* nameBin;
@@ -408,7 +284,7 @@ Handle<Value> GNUtil::convertToJSObj(struct getdns_dict* dict) {
             {
                 getdns_bindata* data = NULL;
                 getdns_dict_get_bindata(dict, (char*)nameBin->data, &data);
-                result->Set(name, convertBinData(data, (char*) nameBin->data));
+                result->Set(name, convertBinData(data, (char*) nameBin->data, stats));
                 break;
             }
             case t_int:
@@ -422,14 +298,14 @@ Handle<Value> GNUtil::convertToJSObj(struct getdns_dict* dict) {
             {
                 getdns_dict* subdict = NULL;
                 getdns_dict_get_dict(dict, (char*)nameBin->data, &subdict);
-                result->Set(name, GNUtil::convertToJSObj(subdict));
+                result->Set(name, GNUtil::convertToJSObj(subdict, stats));
                 break;
             }
             case t_list:
             {
                 getdns_list* list = NULL;
                 getdns_dict_get_list(dict, (char*)nameBin->data, &list);
-                result->Set(name, GNUtil::convertToJSArray(list));
+                result->Set(name, GNUtil::convertToJSArray(list, stats));
                 break;
             }
             default:
@@ -440,6 +316,214 @@ Handle<Value> GNUtil::convertToJSObj(struct getdns_dict* dict) {
     return NanEscapeScope(result);
 }
 
+// JSON string with the characters JSON needs escaped
+void GNUtil::appendJSONString(const char* str, size_t len, std::string* out) {
+    static const char HEX[] = "0123456789abcdef";
+    out->push_back('"');
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char) str[i];
+        if (c == '"' || c == '\\') {
+            out->push_back('\\');
+            out->push_back((char) c);
+        } else if (c < 0x20) {
+            out->append("\\u00");
+            out->push_back(HEX[c >> 4]);
+            out->push_back(HEX[c & 0xF]);
+        } else {
+            out->push_back((char) c);
+        }
+    }
+    out->push_back('"');
+}
+
+static void appendJSONInt(uint32_t value, std::string* out) {
+    char buf[16];
+    int len = snprintf(buf, sizeof(buf), "%u", value);
+    out->append(buf, len);
+}
+
+// As convertBinDataValue, with buffers as { "$bin" : "<hex>" }
+static void appendJSONBinData(getdns_bindata* data, const char* key,
+                              std::string* out) {
+    static const char HEX[] = "0123456789abcdef";
+    switch (classifyBinData(data, key)) {
+        case BinPrintable:
+        {
+            size_t len = data->size;
+            // drop the terminating NUL of strings
+            if (len > 0 && data->data[len - 1] == 0) {
+                --len;
+            }
+            GNUtil::appendJSONString((const char*) data->data, len, out);
+            return;
+        }
+        case BinRoot:
+            out->append("\".\"");
+            return;
+        case BinDname:
+        {
+            char* dname = NULL;
+            if (getdns_convert_dns_name_to_fqdn(data, &dname)
+                == GETDNS_RETURN_GOOD) {
+                GNUtil::appendJSONString(dname, strlen(dname), out);
+                free(dname);
+                return;
+            }
+            break;
+        }
+        case BinIpAddress:
+        {
+            char* ipStr = getdns_display_ip_address(data);
+            if (ipStr) {
+                GNUtil::appendJSONString(ipStr, strlen(ipStr), out);
+                free(ipStr);
+                return;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    out->append("{\"$bin\":\"");
+    for (size_t i = 0; i < data->size; ++i) {
+        out->push_back(HEX[data->data[i] >> 4]);
+        out->push_back(HEX[data->data[i] & 0xF]);
+    }
+    out->append("\"}");
+}
+
+static void appendJSONList(getdns_list* list, std::string* out) {
+    size_t len = 0;
+    getdns_list_get_length(list, &len);
+    out->push_back('[');
+    for (size_t i = 0; i < len; ++i) {
+        if (i > 0) {
+            out->push_back(',');
+        }
+        getdns_data_type type;
+        getdns_list_get_data_type(list, i, &type);
+        switch (type) {
+            case t_bindata:
+            {
+                getdns_bindata* data = NULL;
+                getdns_list_get_bindata(list, i, &data);
+                appendJSONBinData(data, NULL, out);
+                break;
+            }
+            case t_int:
+            {
+                uint32_t res = 0;
+                getdns_list_get_int(list, i, &res);
+                appendJSONInt(res, out);
+                break;
+            }
+            case t_dict:
+            {
+                getdns_dict* dict = NULL;
+                getdns_list_get_dict(list, i, &dict);
+                GNUtil::convertToJSON(dict, out);
+                break;
+            }
+            case t_list:
+            {
+                getdns_list* sublist = NULL;
+                getdns_list_get_list(list, i, &sublist);
+                appendJSONList(sublist, out);
+                break;
+            }
+            default:
+                out->append("null");
+                break;
+        }
+    }
+    out->push_back(']');
+}
+
+static bool isSkipped(const char* name, const char** skipNames) {
+    if (!skipNames) {
+        return false;
+    }
+    for (; *skipNames; ++skipNames) {
+        if (strcmp(name, *skipNames) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void GNUtil::convertToJSON(struct getdns_dict* dict, std::string* out,
+                           const char** skipNames) {
+    if (!dict) {
+        out->append("null");
+        return;
+    }
+    // same as convertToJSObj
+    char* ipStr = getdns_dict_to_ip_string(dict);
+    if (ipStr) {
+        appendJSONString(ipStr, strlen(ipStr), out);
+        free(ipStr);
+        return;
+    }
+    getdns_list* names;
+    getdns_dict_get_names(dict, &names);
+    size_t len = 0;
+    getdns_list_get_length(names, &len);
+    out->push_back('{');
+    bool first = true;
+    for (size_t i = 0; i < len; ++i) {
+        getdns_bindata* nameBin;
+        getdns_list_get_bindata(names, i, &nameBin);
+        const char* name = (const char*) nameBin->data;
+        if (isSkipped(name, skipNames)) {
+            continue;
+        }
+        if (!first) {
+            out->push_back(',');
+        }
+        first = false;
+        appendJSONString(name, strlen(name), out);
+        out->push_back(':');
+        getdns_data_type type;
+        getdns_dict_get_data_type(dict, (char*) name, &type);
+        switch (type) {
+            case t_bindata:
+            {
+                getdns_bindata* data = NULL;
+                getdns_dict_get_bindata(dict, (char*) name, &data);
+                appendJSONBinData(data, name, out);
+                break;
+            }
+            case t_int:
+            {
+                uint32_t res = 0;
+                getdns_dict_get_int(dict, (char*) name, &res);
+                appendJSONInt(res, out);
+                break;
+            }
+            case t_dict:
+            {
+                getdns_dict* subdict = NULL;
+                getdns_dict_get_dict(dict, (char*) name, &subdict);
+                GNUtil::convertToJSON(subdict, out);
+                break;
+            }
+            case t_list:
+            {
+                getdns_list* list = NULL;
+                getdns_dict_get_list(dict, (char*) name, &list);
+                appendJSONList(list, out);
+                break;
+            }
+            default:
+                out->append("null");
+                break;
+        }
+    }
+    out->push_back('}');
+    getdns_list_destroy(names);
+}
+
 // Enums to determine what type a JSValue is
 typedef enum GetdnsType {
     IntType,
@@ -477,9 +561,17 @@ static GetdnsType getGetdnsType(Handle<Value> value) {
     return UnknownType;
 }
 
-getdns_list* GNUtil::convertToList(Handle<Array> array) {
+static getdns_list* createList(getdns_context* context) {
+    return context ? getdns_list_create_with_context(context) : getdns_list_create();
+}
+
+static getdns_dict* createDict(getdns_context* context) {
+    return context ? getdns_dict_create_with_context(context) : getdns_dict_create();
+}
+
+getdns_list* GNUtil::convertToList(Handle<Array> array, getdns_context* context) {
     uint32_t len = array->Length();
-    getdns_list* result = getdns_list_create();
+    getdns_list* result = createList(context);
     for (uint32_t i = 0; i < len; ++i) {
         size_t idx = getdns_list_get_length(result, &idx);
         Local<Value> val = array->Get(i);
@@ -516,7 +608,7 @@ getdns_list* GNUtil::convertToList(Handle<Array> array) {
             case ListType:
                 {
                     Handle<Array> subArray = Handle<Array>::Cast(val);
-                    struct getdns_list* sublist = GNUtil::convertToList(subArray);
+                    struct getdns_list* sublist = GNUtil::convertToList(subArray, context);
                     getdns_list_set_list(result, idx, sublist);
                     getdns_list_destroy(sublist);
                 }
@@ -524,7 +616,7 @@ getdns_list* GNUtil::convertToList(Handle<Array> array) {
             case DictType:
                 {
                     Handle<Object> subObj = val->ToObject();
-                    struct getdns_dict* subdict = GNUtil::convertToDict(subObj);
+                    struct getdns_dict* subdict = GNUtil::convertToDict(subObj, NULL, context);
                     if (subdict) {
                         getdns_list_set_dict(result, idx, subdict);
                         getdns_dict_destroy(subdict);
@@ -538,17 +630,21 @@ getdns_list* GNUtil::convertToList(Handle<Array> array) {
     return result;
 }
 
-getdns_dict* GNUtil::convertToDict(Handle<Object> obj) {
+getdns_dict* GNUtil::convertToDict(Handle<Object> obj, const char** skipNames,
+                                   getdns_context* context) {
     if (obj->IsRegExp() || obj->IsDate() ||
         obj->IsFunction() || obj->IsUndefined() ||
         obj->IsNull() || obj->IsArray()) {
         return NULL;
     }
     Local<Array> names = obj->GetOwnPropertyNames();
-    getdns_dict* result = getdns_dict_create();
+    getdns_dict* result = createDict(context);
     for(unsigned int i = 0; i < names->Length(); i++) {
         Local<Value> nameVal = names->Get(i);
         NanUtf8String name(nameVal);
+        if (isSkipped(*name, skipNames)) {
+            continue;
+        }
         Local<Value> val = obj->Get(nameVal);
         GetdnsType type = getGetdnsType(val);
         switch (type) {
@@ -583,7 +679,7 @@ getdns_dict* GNUtil::convertToDict(Handle<Object> obj) {
             case ListType:
                 {
                     Handle<Array> subArray = Handle<Array>::Cast(val);
-                    struct getdns_list* sublist = GNUtil::convertToList(subArray);
+                    struct getdns_list* sublist = GNUtil::convertToList(subArray, context);
                     getdns_dict_set_list(result, *name, sublist);
                     getdns_list_destroy(sublist);
                 }
@@ -591,7 +687,7 @@ getdns_dict* GNUtil::convertToDict(Handle<Object> obj) {
             case DictType:
                 {
                     Handle<Object> subObj = val->ToObject();
-                    struct getdns_dict* subdict = GNUtil::convertToDict(subObj);
+                    struct getdns_dict* subdict = GNUtil::convertToDict(subObj, NULL, context);
                     if (subdict) {
                         getdns_dict_set_dict(result, *name, subdict);
                         getdns_dict_destroy(subdict);
@@ -29,6 +29,7 @@
 #define _GN_UTIL_H_
 
 #include <node.h>
+#include <string>
 
 struct getdns_dict;
 struct getdns_list;
@@ -36,6 +37,16 @@ struct getdns_context;
 
 using namespace v8;
 
+// Running totals gathered while converting a response
+typedef struct GNConvertStats {
+    // objects and arrays
+    size_t nodes;
+    size_t strings;
+    size_t buffers;
+    // bindata bytes whether they became strings or buffers
+    size_t binaryBytes;
+} GNConvertStats;
+
 // Utility class to do some conversions
 class GNUtil {
 public:
@@ -44,13 +55,30 @@ public:
     static bool attachContextToNode(struct getdns_context* context);
 
     // Conversions from getdns -> JS
-    static Handle<Value> convertToJSArray(struct getdns_list* list);
-    static Handle<Value> convertToJSObj(struct getdns_dict* dict);
+    // stats is optional and accumulated into when given
+    static Handle<Value> convertToJSArray(struct getdns_list* list,
+                                          GNConvertStats* stats = NULL);
+    static Handle<Value> convertToJSObj(struct getdns_dict* dict,
+                                        GNConvertStats* stats = NULL);
     static Handle<Value> convertToBuffer(void* data, size_t size);
+    // Append dict as JSON, bindata converted as for JS with buffers
+    // written as { "$bin" : "<hex>" }.  skipNames is an optional NULL
+    // terminated list of top level names to leave out.
+    static void convertToJSON(struct getdns_dict* dict, std::string* out,
+                              const char** skipNames = NULL);
+    // Append str as a JSON string, escaping what JSON needs escaped
+    static void appendJSONString(const char* str, size_t len, std::string* out);
 
     // Conversions from JS -> getdns
-    static struct getdns_list* convertToList(Handle<Array> array);
-    static struct getdns_dict* convertToDict(Handle<Object> obj);
+    // When context is given the result is allocated with the context
+    // memory functions
+    static struct getdns_list* convertToList(Handle<Array> array,
+                                             struct getdns_context* context = NULL);
+    // skipNames is an optional NULL terminated list of top level
+    // property names to leave out
+    static struct getdns_dict* convertToDict(Handle<Object> obj,
+                                             const char** skipNames = NULL,
+                                             struct getdns_context* context = NULL);
 
     // Helper to determine if an object is a plain dict
     static bool isDictionaryObject(Handle<Value> obj);
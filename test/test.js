@@ -151,6 +151,229 @@ describe("getdns test", function() {
             });
         });
 
+        it("should count queries in stats", function(done) {
+            var ctx = getdns.createContext({"stub" : true});
+            ctx.getAddress("getdnsapi.net", function(err, result) {
+                expect(err).to.not.be.ok(err);
+                var stats = ctx.stats();
+                expect(stats.issued).to.equal(1);
+                expect(stats.completed).to.equal(1);
+                expect(stats.in_flight).to.equal(0);
+                expect(stats.bytes_converted).to.be.above(0);
+                expect(stats.latency.count).to.equal(1);
+                expect(stats.latency.p50).to.be.above(0);
+                finish(ctx, done);
+            });
+            expect(ctx.stats().in_flight).to.equal(1);
+        });
+
+        it("should count response conversion in stats", function(done) {
+            var ctx = getdns.createContext({"stub" : true});
+            ctx.lookup("getdnsapi.net", getdns.RRTYPE_A, function(err, result) {
+                expect(err).to.not.be.ok(err);
+                var conversion = ctx.stats().conversion;
+                expect(conversion.time.count).to.equal(1);
+                expect(conversion.nodes).to.be.above(0);
+                expect(conversion.strings).to.be.above(0);
+                // replies_full
+                expect(conversion.buffers).to.be.above(0);
+                expect(conversion.binary_bytes).to.be.above(0);
+                expect(conversion.slowest).to.have.length(1);
+                var slowest = conversion.slowest[0];
+                expect(slowest.name).to.equal("getdnsapi.net");
+                expect(slowest.type).to.equal(getdns.RRTYPE_A);
+                expect(slowest.lookup).to.equal("general");
+                expect(slowest.nodes).to.equal(conversion.nodes);
+                finish(ctx, done);
+            });
+        });
+
+        it("should count native memory until the context is destroyed", function(done) {
+            var ctx = getdns.createContext({"stub" : true});
+            var before = ctx.stats().memory;
+            ctx.getAddress("getdnsapi.net", function(err, result) {
+                expect(err).to.not.be.ok(err);
+                expect(ctx.destroy()).to.be.ok();
+                // the native destroy is deferred
+                setImmediate(function() {
+                    var after = ctx.stats().memory;
+                    expect(after.bytes_in_use).to.equal(0);
+                    expect(after.allocations).to.equal(0);
+                    expect(after.bytes_reported).to.equal(0);
+                    done();
+                });
+            });
+            var during = ctx.stats().memory;
+            expect(during.bytes_in_use).to.be.above(before.bytes_in_use);
+            expect(during.allocations).to.be.above(before.allocations);
+            expect(during.bytes_reported).to.not.be.below(before.bytes_reported);
+        });
+
+        it("should free pooled memory with the context", function(done) {
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "memory_pool" : true
+            });
+            var pending = 0;
+            var lookup = function(name) {
+                pending++;
+                ctx.getAddress(name, function(err, result) {
+                    expect(err).to.not.be.ok(err);
+                    if (--pending > 0) {
+                        return;
+                    }
+                    expect(ctx.destroy()).to.be.ok();
+                    setImmediate(function() {
+                        // nothing was in use before the context was created
+                        var memory = ctx.stats().memory;
+                        expect(memory.bytes_in_use).to.equal(0);
+                        expect(memory.allocations).to.equal(0);
+                        done();
+                    });
+                });
+            };
+            lookup("getdnsapi.net");
+            lookup("www.getdnsapi.net");
+            expect(ctx.stats().memory.pool_bytes).to.be.above(0);
+            // blocks taken from the pool go back to it after this
+            ctx.memory_pool = false;
+            lookup("nlnetlabs.nl");
+        });
+
+        it("should count replies per upstream", function(done) {
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "upstreams" : [ "8.8.8.8" ],
+                "upstream_stats" : true
+            });
+            ctx.getAddress("getdnsapi.net", function(err, result) {
+                expect(err).to.not.be.ok(err);
+                var upstreams = ctx.stats().upstreams;
+                expect(upstreams).to.have.length(1);
+                expect(upstreams[0].address).to.equal("8.8.8.8");
+                expect(upstreams[0].responses).to.be.above(0);
+                expect(upstreams[0].rcodes[getdns.RCODE_NOERROR]).to.be.above(0);
+                finish(ctx, done);
+            });
+        });
+
+        it("should record lifecycle trace events", function(done) {
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "trace" : 64
+            });
+            ctx.getAddress("getdnsapi.net", function(err, result) {
+                expect(err).to.not.be.ok(err);
+                setImmediate(function() {
+                    var events = ctx.traceEvents();
+                    var names = events.map(function(e) { return e.name + ":" + e.ph; });
+                    expect(names).to.contain("query:b");
+                    expect(names).to.contain("convert:e");
+                    expect(names).to.contain("query:e");
+                    expect(events[0].args.name).to.equal("getdnsapi.net");
+                    expect(ctx.traceEvents()).to.be.empty();
+                    finish(ctx, done);
+                });
+            });
+        });
+
+        it("should replay recorded answers", function(done) {
+            var file = require("path").join(require("os").tmpdir(),
+                                            "getdns-test-" + process.pid + ".rec");
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "record" : file
+            });
+            ctx.lookup("getdnsapi.net", getdns.RRTYPE_A, function(err, recorded) {
+                expect(err).to.not.be.ok(err);
+                expect(ctx.stats().recorded).to.equal(1);
+                // flushes the file
+                ctx.record = false;
+                finish(ctx, function() {
+                    var replay = getdns.createContext({
+                        "replay" : file
+                    });
+                    replay.lookup("getdnsapi.net", getdns.RRTYPE_A, function(err, result) {
+                        expect(err).to.not.be.ok(err);
+                        expect(result.replies_tree[0].answer).to.eql(recorded.replies_tree[0].answer);
+                        var stats = replay.stats().replay;
+                        expect(stats.answered).to.equal(1);
+                        expect(stats.misses).to.equal(0);
+                        require("fs").unlinkSync(file);
+                        finish(replay, done);
+                    });
+                });
+            });
+        });
+
+        it("should use the upstreams again once replay is turned off", function(done) {
+            var file = require("path").join(require("os").tmpdir(),
+                                            "getdns-test-" + process.pid + ".rec");
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "record" : file
+            });
+            ctx.lookup("getdnsapi.net", getdns.RRTYPE_A, function(err, recorded) {
+                expect(err).to.not.be.ok(err);
+                ctx.record = false;
+                finish(ctx, function() {
+                    var replay = getdns.createContext({
+                        "stub" : true,
+                        "replay" : file
+                    });
+                    replay.replay = false;
+                    expect(replay.stats().replay).to.not.be.ok();
+                    // not in the recording, so only an upstream answers it
+                    replay.lookup("www.getdnsapi.net", getdns.RRTYPE_A, function(err, result) {
+                        expect(err).to.not.be.ok(err);
+                        expect(result.replies_tree[0].header.rcode).to.equal(0);
+                        expect(result.replies_tree[0].answer).to.not.be.empty();
+                        require("fs").unlinkSync(file);
+                        finish(replay, done);
+                    });
+                });
+            });
+        });
+
+        it("should resolve a stream of names to JSON lines", function(done) {
+            var fs = require("fs"), os = require("os"), path = require("path");
+            var base = path.join(os.tmpdir(), "getdns-test-" + process.pid);
+            fs.writeFileSync(base + ".in", "getdnsapi.net\n# comment\n\nwww.getdnsapi.net\n");
+            var inFd = fs.openSync(base + ".in", "r");
+            var outFd = fs.openSync(base + ".out", "w");
+            var ctx = getdns.createContext({"stub" : true});
+            ctx.resolveStream(inFd, outFd, { concurrency : 1 }, function(err, summary) {
+                expect(err).to.not.be.ok(err);
+                expect(summary.names).to.equal(2);
+                expect(summary.answered).to.equal(2);
+                fs.closeSync(inFd);
+                fs.closeSync(outFd);
+                var lines = fs.readFileSync(base + ".out", "utf8").trim().split("\n");
+                expect(lines).to.have.length(2);
+                lines.forEach(function(line) {
+                    var result = JSON.parse(line);
+                    expect(result.name).to.contain("getdnsapi.net");
+                    expect(result.response.just_address_answers).to.not.be.empty();
+                    expect(result.response).to.not.have.property("replies_full");
+                });
+                fs.unlinkSync(base + ".in");
+                fs.unlinkSync(base + ".out");
+                finish(ctx, done);
+            });
+        });
+
+        it("should call back in the active domain", function(done) {
+            var domain = require("domain");
+            var ctx = getdns.createContext({"stub" : true});
+            var d = domain.create();
+            d.run(function() {
+                ctx.getAddress("getdnsapi.net", function(err, result) {
+                    expect(process.domain).to.be(d);
+                    finish(ctx, done);
+                });
+            });
+        });
+
         // timeouts
         it("should timeout", function(done) {
             var ctx = getdns.createContext({
@@ -179,6 +402,20 @@ describe("getdns test", function() {
             });
         });
 
+        it("should timeout on a per query deadline", function(done) {
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "timeout" : 10000
+            });
+            ctx.getAddress("getdnsapi.net", { "deadline" : 1 }, function(err, result) {
+                expect(err).to.be.ok();
+                expect(result).to.not.be.ok();
+                expect(err.code).to.equal(getdns.CALLBACK_TIMEOUT);
+                expect(err.elapsed).to.be.a('number');
+                finish(ctx, done);
+            });
+        });
+
         // cancel
         it("should cancel the query", function(done) {
             var ctx = getdns.createContext({"stub" : true});
@@ -194,6 +431,32 @@ describe("getdns test", function() {
             expect(ctx.cancel(transId)).to.be.ok();
         });
 
+        it("should cancel the query through a signal", function(done) {
+            // minimal stand in for AbortSignal
+            var signal = {
+                aborted : false,
+                listeners : [],
+                addEventListener : function(type, fn) {
+                    if (this.listeners.indexOf(fn) < 0) {
+                        this.listeners.push(fn);
+                    }
+                }
+            };
+            var ctx = getdns.createContext({"stub" : true});
+            var transId = ctx.getAddress("getdnsapi.net", { "signal" : signal }, function(err, result) {
+                expect(err).to.be.ok();
+                expect(result).to.not.be.ok();
+                expect(err.code).to.equal(getdns.CALLBACK_CANCEL);
+                finish(ctx, done);
+            });
+            expect(transId).to.not.be.ok();
+            expect(signal.listeners).to.have.length(1);
+            signal.aborted = true;
+            signal.listeners.map(function(fn) {
+                fn.call(signal);
+            });
+        });
+
         // type
         it("should have a buffer as rdata_raw", function(done) {
             var ctx = getdns.createContext({
@@ -212,6 +475,79 @@ describe("getdns test", function() {
         });
     });
 
+    describe("Scheduling", function() {
+        it("should queue queries beyond max_in_flight", function(done) {
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "max_in_flight" : 1,
+                "tenant_weights" : { "a" : 2, "b" : 1 }
+            });
+            var lookups = [
+                { tenant : "a" },
+                { tenant : "b" },
+                { tenant : "b", priority : 3 }
+            ];
+            async.map(lookups, function(ext, cb) {
+                ctx.getAddress("getdnsapi.net", ext, cb);
+            }, function(err, result) {
+                expect(err).to.not.be.ok(err);
+                expect(result).to.have.length(lookups.length);
+                result.map(function(r) {
+                    expect(r.just_address_answers).to.not.be.empty();
+                });
+                finish(ctx, done);
+            });
+        });
+
+        it("should issue queued queries by priority then tenant weight", function(done) {
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "max_in_flight" : 1,
+                "tenant_weights" : { "a" : 2, "b" : 1 }
+            });
+            // the first lookup is issued right away, the rest are queued
+            var lookups = [
+                { label : "first", tenant : "a" },
+                { label : "a1", tenant : "a" },
+                { label : "b1", tenant : "b" },
+                { label : "a2", tenant : "a" },
+                { label : "b2", tenant : "b" },
+                { label : "a3", tenant : "a" },
+                { label : "high", tenant : "b", priority : 3 }
+            ];
+            var order = [];
+            async.each(lookups, function(lookup, cb) {
+                var ext = { "tenant" : lookup.tenant };
+                if (lookup.priority) {
+                    ext.priority = lookup.priority;
+                }
+                ctx.getAddress("getdnsapi.net", ext, function(err, result) {
+                    expect(err).to.not.be.ok(err);
+                    order.push(lookup.label);
+                    cb();
+                });
+            }, function() {
+                expect(order).to.eql(["first", "high", "a1", "a2", "b1", "a3", "b2"]);
+                finish(ctx, done);
+            });
+        });
+
+        it("should cancel a queued query", function(done) {
+            var ctx = getdns.createContext({
+                "stub" : true,
+                "max_in_flight" : 1
+            });
+            ctx.getAddress("getdnsapi.net", function() {});
+            var transId = ctx.getAddress("getdnsapi.net", function(err, result) {
+                expect(err).to.be.ok();
+                expect(err.code).to.equal(getdns.CALLBACK_CANCEL);
+                expect(result).to.not.be.ok();
+                finish(ctx, done);
+            });
+            expect(ctx.cancel(transId)).to.be.ok();
+        });
+    });
+
     describe("DNSSEC", function() {
         it("should return with dnssec_status", function(done) {
             this.timeout(10000);